@@ -2,6 +2,7 @@
 #define CCubeHelix_H
 
 #include <COSNaN.h>
+#include <vector>
 
 //! \brief color helix gradient
 class CCubeHelix {
@@ -38,10 +39,10 @@ class CCubeHelix {
   }
 
   double start() const { return start_; }
-  void setStart(double r) { start_ = r; init(); }
+  void setStart(double r) { start_ = r; init(); table_.valid = false; }
 
   double cycles() const { return cycles_; }
-  void setCycles(double r) { cycles_ = r; }
+  void setCycles(double r) { cycles_ = r; table_.valid = false; }
 
   double saturation() const { return saturation_; }
 
@@ -52,15 +53,28 @@ class CCubeHelix {
     b_.s = r;
 
     init();
+
+    table_.valid = false;
   }
 
   void reset() {
     start_      = 0;
     cycles_     = 1;
     saturation_ = 1;
+
+    table_.valid = false;
   }
 
   QColor interp(double t, bool negate=false) const {
+    double r, g, b;
+
+    interpRGB(t, r, g, b, negate);
+
+    return QColor(int(255*r), int(255*g), int(255*b));
+  }
+
+  // unquantized rgb values (not clamped)
+  void interpRGB(double t, double &r, double &g, double &b, bool negate=false) const {
     double h = ah_ + bh_*t;
     double l = pow(al_ + bl_*t, std::max(cycles_, 0.01));
     double a = (as_ + bs_*t)*l*(1 - l);
@@ -68,19 +82,90 @@ class CCubeHelix {
     double cosh = cos(h);
     double sinh = sin(h);
 
-    double r = l + a*(-0.14861*cosh + 1.78277*sinh);
-    double g = l + a*(-0.29227*cosh - 0.90649*sinh);
-    double b = l + a*(+1.97294*cosh);
+    r = l + a*(-0.14861*cosh + 1.78277*sinh);
+    g = l + a*(-0.29227*cosh - 0.90649*sinh);
+    b = l + a*(+1.97294*cosh);
 
     if (negate) {
       r = 1.0 - r;
       g = 1.0 - g;
       b = 1.0 - b;
     }
+  }
 
-    return QColor(int(255*r), int(255*g), int(255*b));
+  // batch unquantized rgb values (3 floats per value) interpolated from table of values
+  // for current parameters (updateTable should be called after parameter change, values
+  // are calculated exactly if table is not built for current parameters and negate)
+  template<typename T>
+  void interpRGB(const T *t, int n, float *rgb, bool negate=false) const {
+    bool valid = isTableValid(negate);
+
+    const auto *values = table_.values.data();
+
+    for (int i = 0; i < n; ++i, rgb += 3) {
+      double s = double(t[i])*tableSteps;
+
+      // no table, outside table range (or NaN) or first steps of gamma < 1 (infinite slope
+      // at zero)
+      if (! valid || ! (s >= table_.minStep && s <= tableSteps)) {
+        double r, g, b;
+
+        interpRGB(double(t[i]), r, g, b, negate);
+
+        rgb[0] = float(r); rgb[1] = float(g); rgb[2] = float(b);
+
+        continue;
+      }
+
+      int j = std::min(int(s), tableSteps - 1);
+
+      float m = float(s - j);
+
+      const auto *v = &values[3*j];
+
+      rgb[0] = v[0] + m*(v[3] - v[0]);
+      rgb[1] = v[1] + m*(v[4] - v[1]);
+      rgb[2] = v[2] + m*(v[5] - v[2]);
+    }
+  }
+
+  // is table built for current parameters and negate
+  bool isTableValid(bool negate) const { return (table_.valid && table_.negate == negate); }
+
+  // build table of values for current parameters and negate (if changed), must be called
+  // before batch interpRGB (which only reads the table so is safe for concurrent use)
+  void updateTable(bool negate) {
+    if (isTableValid(negate))
+      return;
+
+    table_.values.resize(3*(tableSteps + 1));
+
+    auto *v = table_.values.data();
+
+    for (int i = 0; i <= tableSteps; ++i, v += 3) {
+      double r, g, b;
+
+      interpRGB(double(i)/tableSteps, r, g, b, negate);
+
+      v[0] = float(r); v[1] = float(g); v[2] = float(b);
+    }
+
+    table_.negate  = negate;
+    table_.minStep = (cycles_ < 1.0 ? 16.0 : 0.0);
+    table_.valid   = true;
   }
 
+ private:
+  static const int tableSteps = 4096;
+
+  // table of values (invalidated on parameter change)
+  struct Table {
+    bool               valid   { false };
+    bool               negate  { false };
+    double             minStep { 0.0 };
+    std::vector<float> values;
+  };
+
  private:
   double start_      { 1.0/3.0 };
   double cycles_     { 1 };
@@ -90,6 +175,8 @@ class CCubeHelix {
   double ah_, bh_;
   double as_, bs_;
   double al_, bl_;
+
+  Table table_;
 };
 
 #endif
@@ -113,6 +113,8 @@ class CQColorsEditCanvas : public QFrame {
   void windowToPixel(double wx, double wy, double &px, double &py) const;
   void pixelToWindow(double px, double py, double &wx, double &wy) const;
 
+  void colorBarPixelRange(double &pxp1, double &pxp2) const;
+
  public slots:
   void setShowPoints  (bool b);
   void setShowLines   (bool b);
@@ -131,9 +133,13 @@ class CQColorsEditCanvas : public QFrame {
 
  private slots:
   void updateSlot();
+  //! repaint changed x range only (only emitted by palette setDefinedColor, other
+  //! changes, e.g. add, remove or set all colors, still repaint everything)
+  void updateRangeSlot(double xmin, double xmax);
 
  signals:
-  void colorsChanged();
+  //! defined color i edited by mouse drag
+  void definedColorChanged(int i);
 
  private:
   struct MouseData {
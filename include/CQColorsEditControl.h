@@ -93,6 +93,7 @@ class CQColorsEditControl : public QScrollArea {
 
  private slots:
   void updateDefinedState();
+  void updateDefinedColor(int i);
 
   void colorTypeChanged(int);
   void colorModelChanged(int);
@@ -25,6 +25,9 @@ class CQColorsEditDefinedColors : public QTableWidget {
 
   void updateColors(CQColorsPalette *palette);
 
+  //! update row for palette defined color i only (color edited, stop count unchanged)
+  void updateColor(CQColorsPalette *palette, int i);
+
   size_t numRealColors() const { return realColors_.size(); }
 
   const RealColor &realColor(int i) const;
@@ -7,10 +7,14 @@
 #include <QImage>
 
 #include <string>
+#include <algorithm>
 #include <map>
 #include <memory>
+#include <atomic>
+#include <mutex>
 #include <cmath>
 #include <cassert>
+#include <cstdint>
 
 #define CQCOLORS_TCL 1
 
@@ -53,6 +57,20 @@ class CQColorsPalette : public QObject {
     XYZ,
   };
 
+  //! interpolation space for defined colors (MODEL uses color model)
+  enum class InterpSpace {
+    MODEL,
+    OKLAB,
+    LAB,
+    LCH
+  };
+
+  //! interpolation between defined colors (CUBIC is monotone cubic per channel)
+  enum class InterpMode {
+    LINEAR,
+    CUBIC
+  };
+
   enum class WrapMode {
     NONE,
     REPEAT,
@@ -72,6 +90,19 @@ class CQColorsPalette : public QObject {
 
   using DefinedColors = std::vector<DefinedColor>;
 
+  //! float rgba color (layout matches QImage::Format_RGBA32FPx4 pixel)
+  struct ColorF {
+    float r { 0.0f };
+    float g { 0.0f };
+    float b { 0.0f };
+    float a { 1.0f };
+  };
+
+  using ColorFs = std::vector<ColorF>;
+  using Reals   = std::vector<double>;
+  using Floats  = std::vector<float>;
+  using Colors  = std::vector<QColor>;
+
  public:
   static ColorType stringToColorType(const QString &str) {
     if      (str == "model"    ) return ColorType::MODEL;
@@ -142,60 +173,58 @@ class CQColorsPalette : public QObject {
 
   //! get/set color calculation type
   ColorType colorType() const { return colorType_; }
-  void setColorType(ColorType t) { colorType_ = t; }
+  void setColorType(ColorType t) { if (t != colorType_) { colorType_ = t; invalidate(); } }
 
   //! get/set color model
   ColorModel colorModel() const { return colorModel_; }
-  void setColorModel(ColorModel m) { colorModel_ = m; }
+  void setColorModel(ColorModel m) { if (m != colorModel_) { colorModel_ = m; invalidate(); } }
 
   //---
 
-#if 0
-  //! get/set gamma correction : NOT USED yet
+  //! get/set gamma correction (output red, green and blue raised to 1/gamma, 1 for none)
   double gamma() const { return gamma_; }
-  void setGamma(double g) { gamma_ = g; }
-#endif
+  void setGamma(double g) { gamma_ = g; invalidate(); }
 
   //---
 
   // model
   void setRgbModel(int r, int g, int b);
 
-  int redModel() const { return modelData_.rModel; }
-  void setRedModel(int r) { modelData_.rModel = r; }
+  int redModel() const { return modelData_->rModel; }
+  void setRedModel(int r) { modelData_.edit().rModel = r; invalidate(); }
 
-  int greenModel() const { return modelData_.gModel; }
-  void setGreenModel(int r) { modelData_.gModel = r; }
+  int greenModel() const { return modelData_->gModel; }
+  void setGreenModel(int r) { modelData_.edit().gModel = r; invalidate(); }
 
-  int blueModel() const { return modelData_.bModel; }
-  void setBlueModel(int r) { modelData_.bModel = r; }
+  int blueModel() const { return modelData_->bModel; }
+  void setBlueModel(int r) { modelData_.edit().bModel = r; invalidate(); }
 
-  bool isGray() const { return modelData_.gray; }
-  void setGray(bool b) { modelData_.gray = b; }
+  bool isGray() const { return modelData_->gray; }
+  void setGray(bool b) { modelData_.edit().gray = b; invalidate(); }
 
-  bool isRedNegative() const { return modelData_.redNegative; }
-  void setRedNegative(bool b) { modelData_.redNegative = b; }
+  bool isRedNegative() const { return modelData_->redNegative; }
+  void setRedNegative(bool b) { modelData_.edit().redNegative = b; invalidate(); }
 
-  bool isGreenNegative() const { return modelData_.greenNegative; }
-  void setGreenNegative(bool b) { modelData_.greenNegative = b; }
+  bool isGreenNegative() const { return modelData_->greenNegative; }
+  void setGreenNegative(bool b) { modelData_.edit().greenNegative = b; invalidate(); }
 
-  bool isBlueNegative() const { return modelData_.blueNegative; }
-  void setBlueNegative(bool b) { modelData_.blueNegative = b; }
+  bool isBlueNegative() const { return modelData_->blueNegative; }
+  void setBlueNegative(bool b) { modelData_.edit().blueNegative = b; invalidate(); }
 
-  void setRedMin(double r) { modelData_.redMin = std::min(std::max(r, 0.0), 1.0); }
-  double redMin() const { return modelData_.redMin; }
-  void setRedMax(double r) { modelData_.redMax = std::min(std::max(r, 0.0), 1.0); }
-  double redMax() const { return modelData_.redMax; }
+  void setRedMin(double r) { modelData_.edit().redMin = std::min(std::max(r, 0.0), 1.0); invalidate(); }
+  double redMin() const { return modelData_->redMin; }
+  void setRedMax(double r) { modelData_.edit().redMax = std::min(std::max(r, 0.0), 1.0); invalidate(); }
+  double redMax() const { return modelData_->redMax; }
 
-  void setGreenMin(double r) { modelData_.greenMin = std::min(std::max(r, 0.0), 1.0); }
-  double greenMin() const { return modelData_.greenMin; }
-  void setGreenMax(double r) { modelData_.greenMax = std::min(std::max(r, 0.0), 1.0); }
-  double greenMax() const { return modelData_.greenMax; }
+  void setGreenMin(double r) { modelData_.edit().greenMin = std::min(std::max(r, 0.0), 1.0); invalidate(); }
+  double greenMin() const { return modelData_->greenMin; }
+  void setGreenMax(double r) { modelData_.edit().greenMax = std::min(std::max(r, 0.0), 1.0); invalidate(); }
+  double greenMax() const { return modelData_->greenMax; }
 
-  void setBlueMin(double r) { modelData_.blueMin = std::min(std::max(r, 0.0), 1.0); }
-  double blueMin() const { return modelData_.blueMin; }
-  void setBlueMax(double r) { modelData_.blueMax = std::min(std::max(r, 0.0), 1.0); }
-  double blueMax() const { return modelData_.blueMax; }
+  void setBlueMin(double r) { modelData_.edit().blueMin = std::min(std::max(r, 0.0), 1.0); invalidate(); }
+  double blueMin() const { return modelData_->blueMin; }
+  void setBlueMax(double r) { modelData_.edit().blueMax = std::min(std::max(r, 0.0), 1.0); invalidate(); }
+  double blueMax() const { return modelData_->blueMax; }
 
   //---
 
@@ -208,13 +237,24 @@ class CQColorsPalette : public QObject {
   DefinedColors definedColors() const;
   ColorMap definedValueColors() const;
 
-  // get defined color
+  // get stored defined color values, normalized values (0-1) and colors without copy
+  // (value order, not inverted, references invalidated by defined color changes)
+  const Reals  &definedStopValues () const { return definedData_->definedValues ; }
+  const Reals  &definedStopXValues() const { return definedData_->definedXValues; }
+  const Colors &definedStopColors () const { return definedData_->definedColors ; }
+
+  // NOTE: defined color indices (definedColor, definedColorValue, definedColorData,
+  // setDefinedColor, removeDefinedColor and getColor(int) of a defined palette) are in
+  // value order. Previous versions used insertion order, so code which added colors out
+  // of value order must look up the index by value (see doc/ReleaseNotes.md)
+
+  // get defined color (i in value order)
   QColor definedColor(int i) const;
 
-  // get defined color value
+  // get defined color value (i in value order)
   double definedColorValue(int i) const;
 
-  // get defined color data
+  // get defined color data (i in value order)
   DefinedColor definedColorData(int i) const;
 
   // is existing defined color
@@ -223,10 +263,16 @@ class CQColorsPalette : public QObject {
   // add new defined color
   void addDefinedColor(double v, const QColor &c);
 
+  // add new defined colors (any order, single rebuild of color data)
+  void addDefinedColors(const DefinedColors &colors);
+
+  // remove defined color (i in value order)
+  void removeDefinedColor(int i);
+
   // clear defined colors
   void resetDefinedColors();
 
-  // set individual defined color
+  // set individual defined color (i in value order)
   void setDefinedColor(int i, const QColor &c);
 
   // set defined colors
@@ -245,6 +291,14 @@ class CQColorsPalette : public QObject {
   bool isInverted() const;
   void setInverted(bool b);
 
+  // get/set interpolation space for defined colors (perceptual spaces ignore color model)
+  InterpSpace interpSpace() const;
+  void setInterpSpace(const InterpSpace &space);
+
+  // get/set interpolation mode for defined colors
+  InterpMode interpMode() const;
+  void setInterpMode(const InterpMode &mode);
+
   //---
 
   // get/set default value for number of colors
@@ -253,17 +307,117 @@ class CQColorsPalette : public QObject {
 
   //---
 
-  //! get indexed color at i (from n colors)
+  //! get indexed color at i (from n colors, defined colors in value order)
   QColor getColor(int i, int n=-1, WrapMode wrapMode=WrapMode::NONE) const;
 
   //! interpolate color at x (if scaled then input x has been adjusted to min/max range)
   QColor getColor(double x, bool scale=false, bool invert=false) const;
 
+  //! interpolate n colors at x values into caller owned rgb array (see getColor)
+  //! (if premultiplied then rgb is premultiplied by alpha, as QImage::Format_ARGB32_Premultiplied)
+  void getColors(const double *x, int n, QRgb *rgb, bool scale=false, bool invert=false,
+                 bool premultiplied=false) const;
+  void getColors(const float  *x, int n, QRgb *rgb, bool scale=false, bool invert=false,
+                 bool premultiplied=false) const;
+
+  //! interpolate float rgba color(s) at x (no 8-bit quantization, see getColor)
+  ColorF getColorF(double x, bool scale=false, bool invert=false) const;
+  void getColorsF(const double *x, int n, ColorF *c, bool scale=false, bool invert=false) const;
+  void getColorsF(const float  *x, int n, ColorF *c, bool scale=false, bool invert=false) const;
+
+  //! interpolate 16-bit per channel color(s) at x (see getColor)
+  QRgba64 getColor64(double x, bool scale=false, bool invert=false) const;
+  void getColors64(const double *x, int n, QRgba64 *c, bool scale=false, bool invert=false) const;
+  void getColors64(const float  *x, int n, QRgba64 *c, bool scale=false, bool invert=false) const;
+
+  //! colorize full range integer values (0-255 or 0-65535 mapped to 0-1) using
+  //! table of colors for all input values (built on demand)
+  void getColors(const uint8_t  *v, int n, QRgb *rgb, bool scale=false, bool invert=false,
+                 bool premultiplied=false) const;
+  void getColors(const uint16_t *v, int n, QRgb *rgb, bool scale=false, bool invert=false,
+                 bool premultiplied=false) const;
+
+  //! colorize grayscale image (Grayscale8 or Grayscale16) to ARGB32 image
+  //! (ARGB32_Premultiplied if premultiplied, other formats are converted to Grayscale8)
+  QImage colorizeImage(const QImage &image, bool scale=false, bool invert=false,
+                       bool premultiplied=false) const;
+
+  //! are any colors translucent (defined colors with alpha less than one)
+  bool hasAlpha() const;
+
+  //! get mean (box filtered) color over x range x0 to x1 (see getColor)
+  //! (constant time from cumulative color integrals, built on demand)
+  QColor getMeanColor(double x0, double x1, bool scale=false, bool invert=false) const;
+  ColorF getMeanColorF(double x0, double x1, bool scale=false, bool invert=false) const;
+
+  //! get color at x pre-filtered for sample footprint (x range covered by one sample)
+  //! from power of two pyramid of box filtered levels (built on demand)
+  //! (exact color if footprint is less than half a cell of the finest level)
+  QColor getMipColor(double x, double footprint, bool scale=false, bool invert=false) const;
+  ColorF getMipColorF(double x, double footprint, bool scale=false, bool invert=false) const;
+
+  //! number of pyramid levels (level 0 is finest, each level has half the cells of previous)
+  int numMipLevels() const;
+
+  //! get pyramid level for (mapped) footprint (-1 if not minified)
+  int mipLevel(double footprint) const;
+
+  //! sampler for getColor at sorted x values
+  //!
+  //! remembers the last defined color segment so increasing (or decreasing) x values
+  //! step to the next segment instead of searching all values
+  class Sampler {
+   public:
+    explicit Sampler(const CQColorsPalette *palette, bool scale=false, bool invert=false) :
+     palette_(palette), scale_(scale), invert_(invert) {
+    }
+
+    //! interpolate color at x (same result as palette getColor)
+    QColor getColor(double x);
+
+    //! reset segment (restart search)
+    void reset() { segment_ = 0; }
+
+   private:
+    const CQColorsPalette* palette_ { nullptr }; //!< parent palette
+    bool                   scale_   { false };   //!< scale input x
+    bool                   invert_  { false };   //!< invert input x
+    size_t                 segment_ { 0 };       //!< last segment end index
+  };
+
+  //---
+
+  //! get/set lookup table size (number of baked colors, 0 to evaluate exactly)
+  int lutSize() const { return lutData_.size; }
+  void setLutSize(int n);
+
+  //! get/set interpolate between lookup table entries (else nearest entry)
+  bool isLutInterp() const { return lutData_.interp; }
+  void setLutInterp(bool b);
+
+  //! get/set max color error (CIE76 delta E) for automatically sized lookup table
+  //! (smallest size meeting error is used instead of lutSize, 0 for fixed size)
+  double lutMaxError() const { return lutData_.maxError; }
+  void setLutMaxError(double e);
+
+  //! is lookup table used (fixed size or max error)
+  bool isLut() const { return (lutSize() > 0 || lutMaxError() > 0.0); }
+
+  //! number of baked lookup table colors (chosen size for max error, 0 if no table)
+  int lutColorsSize() const;
+
+  //! max color error (CIE76 delta E) of lookup table colors against exact colors
+  double lutError() const;
+
   //---
 
   //! interpolate color for model ind and x value
   static double interpModel(int ind, double x);
 
+  //! interpolate color for model ind and x value (0-1) from table of model values
+  //! shared by all palettes
+  static double tableModel(int ind, double x);
+
   //---
 
  public:
@@ -303,7 +457,8 @@ class CQColorsPalette : public QObject {
   bool isCubeNegative() const;
   void setCubeNegative(bool b);
 
-  CCubeHelix *cubeHelix() const;
+  //! get cube helix data (read only, change parameters with palette setters)
+  const CCubeHelix *cubeHelix() const;
 
   //---
 
@@ -315,6 +470,11 @@ class CQColorsPalette : public QObject {
 
   //---
 
+  //! get/set gradient image columns are box filtered from mip levels when the image is
+  //! narrower than the palette detail (else point sampled, default)
+  bool isGradientFiltered() const { return gradientFiltered_; }
+  void setGradientFiltered(bool b);
+
   QImage getGradientImage(const QSize &size);
 
  private:
@@ -359,44 +519,346 @@ class CQColorsPalette : public QObject {
 
     return QColor::fromRgbF(interpValue(r1, r2, f),
                             interpValue(g1, g2, f),
-                            interpValue(b1, b2, f));
+                            interpValue(b1, b2, f),
+                            interpValue(a1, a2, f));
   }
 
   //! interpolate between two HSV colors
   static QColor interpHSV(const QColor &c1, const QColor &c2, double f) {
-    qreal h1, s1, v1, a1;
-    qreal h2, s2, v2, a2;
+    double h1, s1, v1;
+    double h2, s2, v2;
 
-    c1.getHsvF(&h1, &s1, &v1, &a1);
-    c2.getHsvF(&h2, &s2, &v2, &a2);
+    colorToHsv(c1, h1, s1, v1);
+    colorToHsv(c2, h2, s2, v2);
 
     // fix invalid hue (gray)
     if      (h1 < 0 && h2 < 0) { h1 = 0.0; h2 = 0.0; }
     else if (h1 < 0)           { h1 = h2; }
     else if (h2 < 0)           { h2 = h1; }
 
-    return QColor::fromHsvF(interpValue(h1, h2, f),
-                            interpValue(s1, s2, f),
-                            interpValue(v1, v2, f));
+    return hsvToColor(interpValue(h1, h2, f),
+                      interpValue(s1, s2, f),
+                      interpValue(v1, v2, f),
+                      interpValue(c1.alphaF(), c2.alphaF(), f));
+  }
+
+  //! convert hsv (0-1) to rgb (0-1) without branching on hue sector
+  //! (see CQColorsSIMD::hsvToRgb for vector version)
+  static void hsvToRgb(double h, double s, double v, double &r, double &g, double &b) {
+    // channel n is v - v*s*clamp(min(k, 4 - k), 0, 1) for k = (n + 6*h) mod 6
+    auto channel = [&](double n) {
+      double k = n + 6.0*h;
+
+      k -= 6.0*std::floor(k/6.0);
+
+      return v - v*s*std::max(0.0, std::min({k, 4.0 - k, 1.0}));
+    };
+
+    r = channel(5.0);
+    g = channel(3.0);
+    b = channel(1.0);
+  }
+
+  //! convert rgb (0-1) to hsv (0-1), hue is -1 for gray (same as QColor::getHsvF)
+  static void rgbToHsv(double r, double g, double b, double &h, double &s, double &v) {
+    double max = std::max({r, g, b});
+    double min = std::min({r, g, b});
+    double d   = max - min;
+
+    v = max;
+    s = (max > 0.0 ? d/max : 0.0);
+
+    if (d <= 0.0) {
+      h = -1.0;
+      return;
+    }
+
+    double h6 = (max == r ? (g - b)/d : (max == g ? (b - r)/d + 2.0 : (r - g)/d + 4.0));
+
+    h = (h6 < 0.0 ? h6 + 6.0 : h6)/6.0;
+  }
+
+  //! get color from hsv (0-1) and alpha
+  static QColor hsvToColor(double h, double s, double v, double a=1.0) {
+    double r, g, b;
+
+    hsvToRgb(h, s, v, r, g, b);
+
+    return QColor::fromRgbF(r, g, b, a);
+  }
+
+  //! get hsv (0-1) of color
+  static void colorToHsv(const QColor &c, double &h, double &s, double &v) {
+    qreal r, g, b;
+
+    c.getRgbF(&r, &g, &b);
+
+    rgbToHsv(r, g, b, h, s, v);
   }
 
+  //! get affine transform (3 rows of three scales and an offset) from linear color model
+  //! (CMY, YIQ or XYZ) values to rgb (nullptr if not linear model)
+  static const float *linearModelMatrix(ColorModel model);
+
+  //! convert color model values (0-1) to rgb (not clamped)
+  static void modelToRgb(ColorModel model, double c1, double c2, double c3,
+                         double &r, double &g, double &b);
+
+  //! convert n color model values (0-1) to rgb (not clamped) using vector kernels if supported
+  static void modelsToRgb(ColorModel model, const float *c1, const float *c2, const float *c3,
+                          int n, float *r, float *g, float *b);
+
+  //! get color from color model values (0-1)
+  static QColor modelToColor(ColorModel model, double c1, double c2, double c3);
+
  protected:
   void init();
 
   void initFunctions();
 
+  //! mark cached (derived) color data as invalid
+  void invalidate();
+
+  //! rebuild cached (derived) color data for normalized (mapped) x range
+  void invalidateRange(double xmin, double xmax);
+
+  //! get input x range (unbounded at ends) which maps to normalized x range
+  void unmapColorRange(double xmin, double xmax, bool scale, bool invert,
+                       double &x1, double &x2) const;
+
+  //! map x to defined color range (scale and invert)
+  double mapColorX(double x, bool scale, bool invert) const;
+
+  //! exact (unmapped) color at x
+  QColor interpColor(double x) const;
+
+  //! lookup table color at x
+  QColor lutColor(double x) const;
+
+  //! color at x from lookup table colors (interpolated or nearest)
+  static ColorF lutColorF(const ColorFs &colors, bool interp, double x);
+
+  void updateLut() const;
+
+  //! bake n lookup table colors
+  void bakeLut(int n) const;
+  void bakeLutRange(int i1, int i2) const;
+
+  //! max delta E of lookup table colors against test colors (lab)
+  double lutTestError(const Reals &labs) const;
+
+  //! exact test colors (lab) for lookup table error
+  void lutTestColors(Reals &labs) const;
+
+  //! cumulative color integral from 0 to mapped x (r, g, b, a)
+  void integralColor(double x, double *s) const;
+
+  void updateIntegrals() const;
+  void updateIntegrals(int i1, int i2) const;
+
+  void updateMipLevels() const;
+  void updateMipLevels(int i1, int i2) const;
+
+  //! update normalized defined color values
+  void updateDefinedValues();
+
+  //! update defined color data for color i inserted or removed (only adjacent segments
+  //! are rebuilt, positions are rescaled if min/max changed)
+  void updateDefinedInsert(size_t i, bool rescale);
+  void updateDefinedRemove(size_t i, bool rescale);
+
+  //! update normalized values and segment positions for changed min/max
+  void updateDefinedPositions();
+
+  //! update defined color alpha flag, segment i records and cubic coefficients
+  void updateDefinedAlpha();
+  void updateDefinedSegment(size_t i);
+  void updateDefinedCubic();
+
+  // evaluation data and static evaluation functions are shared with snapshot
+  friend class CQColorsPaletteSnapshot;
+
+  struct DefinedData;
+  struct ModelChannel;
+  struct GammaData;
+  struct EvalData;
+  struct IntTables;
+
+  //! get defined color segment (start/end index and fraction) for normalized x
+  static void definedSegment(const Reals &xvalues, double x, size_t &i1, size_t &i2, double &m);
+  void definedSegment(double x, size_t &i1, size_t &i2, double &m, size_t &hint) const;
+
+  //! get color for defined color segment (start/end index and fraction)
+  static QColor interpDefinedColor(const DefinedData &data, ColorModel model,
+                                   size_t i1, size_t i2, double m);
+
+  //! are defined colors interpolated from segment records (perceptual space or cubic)
+  static bool isSegmentInterp(const DefinedData &data);
+
+  //! get interpolation space values for defined color segment i and fraction m
+  static void definedValues(const DefinedData &data, ColorModel model, size_t i, double m,
+                            double &c1, double &c2, double &c3);
+
+  //! get rgb for defined color segment i and fraction m (from segment records)
+  static void definedRGB(const DefinedData &data, ColorModel model, size_t i, double m,
+                         double &r, double &g, double &b);
+
+  //! get alpha for defined color segment i and fraction m (always linear)
+  static double definedAlpha(const DefinedData &data, size_t i, double m);
+
+  //! get model rgb values for x from red, green and blue channels
+  static void modelRGB(const ModelChannel *channels, double x, double &r, double &g, double &b);
+
+  //! evaluator type (resolved from color type, model and flags)
+  enum class EvalType {
+    DEFAULT,
+    LUT,
+    DEFINED_EMPTY,
+    DEFINED_RGB,
+    DEFINED_HSV,
+    DEFINED_SEGMENT,
+    MODEL_GRAY,
+    MODEL_RGB,
+    MODEL_HSV,
+    MODEL_LINEAR,
+    CUBEHELIX
+  };
+
+  //! evaluator proc for mapped x
+  using EvalProc = QColor (*)(const EvalData &eval, double x);
+
+  template<EvalType TYPE>
+  static QColor evalColor(const EvalData &eval, double x);
+
+  //! evaluator proc for gamma correction of base evaluator
+  static QColor evalGammaColor(const EvalData &eval, double x);
+
+  //! update evaluator for current state
+  void updateEvaluator();
+
+  //! set evaluator procs for evaluation data
+  static void initEvaluator(EvalData &eval);
+
+  //! get evaluation data (lookup table built if used)
+  const EvalData &evalData() const;
+
+  //! map x to defined color range of evaluation data (scale and invert)
+  static double mapColorX(const EvalData &eval, double x, bool scale, bool invert);
+
+  //! are any colors of evaluation data translucent
+  static bool hasAlpha(const EvalData &eval);
+
+  //! update gamma correction table for current gamma
+  void updateGamma();
+
+  //! is gamma correction applied
+  bool isGammaCorrected() const { return ! gammaData_.values.empty(); }
+
+  //! get gamma corrected channel value (from table)
+  static double gammaValue(const GammaData &data, double v);
+
+  //! get gamma corrected color (alpha unchanged, color unchanged if no table)
+  static QColor gammaColor(const GammaData &data, const QColor &c);
+
+  //! interpolate n colors from evaluation data (palette and snapshot batch colors)
+  template<typename T, typename C>
+  static void getColorsT(const EvalData &eval, const T *x, int n, C *c, bool scale, bool invert);
+
+  template<typename T>
+  static void getColorsRgbT(const EvalData &eval, const T *x, int n, QRgb *rgb, bool scale,
+                            bool invert, bool premultiplied);
+
+  //! get integer input table for evaluation data (built on first use)
+  static const QRgb *intTable(const EvalData &eval, IntTables &tables, int bits, bool scale,
+                              bool invert, bool premultiplied);
+
+  //! colorize grayscale image from integer input tables of evaluation data
+  static QImage colorizeImage(const EvalData &eval, IntTables &tables, const QImage &image,
+                              bool scale, bool invert, bool premultiplied);
+
+  //! get integer table index for flags (and flags for index)
+  static int intTableIndex(bool scale, bool invert, bool premultiplied) {
+    return (scale ? 1 : 0) | (invert ? 2 : 0) | (premultiplied ? 4 : 0);
+  }
+
+  static void intTableFlags(int ind, bool &scale, bool &invert, bool &premultiplied) {
+    scale         = (ind & 1);
+    invert        = (ind & 2);
+    premultiplied = (ind & 4);
+  }
+
+  void invalidateIntTables();
+
 #ifdef CQCOLORS_TCL
+  //! tcl interpreter for functions (one per thread, shared by palettes)
   CQTcl *qtcl() const;
 #endif
 
  signals:
+  //! colors changed (emitted on invalidate, so by all edits except setDefinedColor)
   void colorsChanged();
 
+  //! colors changed in normalized x range only (as getColor x without scale).
+  //! Only emitted by setDefinedColor, other edits (add, remove, set all) are not range limited
+  void colorsRangeChanged(double xmin, double xmax);
+
  protected:
   struct ColorFn {
     std::string fn;
   };
 
+  //! copy on write data (copies share data until edited)
+  //!
+  //! Copying marks the data shared (and it stays shared), so edit() always copies data
+  //! which was ever handed to a copy. shared_ptr use_count() is not used as it is only
+  //! approximate when copies are released on other threads.
+  template<typename T>
+  class CowData {
+   public:
+    CowData() : block_(std::make_shared<Block>()) { }
+
+    CowData(const CowData &rhs) : block_(rhs.share()) { }
+
+    CowData &operator=(const CowData &rhs) {
+      if (&rhs != this)
+        block_ = rhs.share();
+
+      return *this;
+    }
+
+    const T &operator*() const { return block_->data; }
+    const T *operator->() const { return &block_->data; }
+
+    //! get data for edit (unshare from copies)
+    T &edit() {
+      if (block_->shared.load(std::memory_order_acquire))
+        block_ = std::make_shared<Block>(block_->data);
+
+      return block_->data;
+    }
+
+   private:
+    struct Block {
+      Block() = default;
+
+      explicit Block(const T &data) : data(data) { }
+
+      T                 data;              //!< data
+      std::atomic<bool> shared { false };  //!< has been copied (never edit in place)
+    };
+
+    using BlockP = std::shared_ptr<Block>;
+
+    BlockP share() const {
+      block_->shared.store(true, std::memory_order_release);
+
+      return block_;
+    }
+
+   private:
+    BlockP block_; //!< shared data block
+  };
+
   QString      name_; //!< name
   QString      desc_; //!< description
 
@@ -423,7 +885,7 @@ class CQColorsPalette : public QObject {
     double blueMax       { 1.0 };   //!< blue maximum
   };
 
-  ModelData modelData_;
+  CowData<ModelData> modelData_;
 
   // Functions
   struct TclFnData {
@@ -434,35 +896,141 @@ class CQColorsPalette : public QObject {
 
   TclFnData tclFnData_;
 
-#ifdef CQCOLORS_TCL
-  CQTcl* qtcl_ { nullptr }; //!< qtcl pointer for functions
-#endif
-
   // CubeHelix
-  CCubeHelix* cubeHelix_    { nullptr }; //!< cube helix data
+  CCubeHelix* cubeHelix_    { nullptr }; //!< cube helix data (always set)
   bool        cubeNegative_ { false };   //!< is cube helix negated
 
   // Defined
+  struct DefinedFloats {
+    Floats x;             //!< normalized values
+    Floats rgbSegments;   //!< rgb segment records (see CQColorsSIMD::Stops)
+    Floats hsvSegments;   //!< hsv segment records (see CQColorsSIMD::Stops)
+    Floats spaceSegments; //!< interpolation space segment records (same layout)
+    Floats rgbCubic;      //!< rgb cubic coefficients (4 per channel per segment)
+    Floats hsvCubic;      //!< hsv cubic coefficients (4 per channel per segment)
+    Floats spaceCubic;    //!< interpolation space cubic coefficients
+    Floats alpha;         //!< alpha start and delta (2 per segment)
+  };
+
   struct DefinedData {
-    DefinedColors definedColors;                //!< array of defined colors
-    ColorMap      definedValueColors;           //!< map of defined colors by value
+    // stops sorted by value (parallel arrays)
+    Reals         definedValues;                //!< values
+    Reals         definedXValues;               //!< normalized values
+    Colors        definedColors;                //!< colors
+    DefinedFloats definedFloats;                //!< float stop data (for vector kernels)
     double        definedMin         { 0.0 };   //!< colors min value (for scaling)
     double        definedMax         { 0.0 };   //!< colors max value (for scaling)
     bool          definedDistinct    { false }; //!< prefer use distinct colors
     bool          definedInverted    { false }; //!< invert color order
+    bool          definedAlpha       { false }; //!< any color not opaque
+    InterpSpace   definedSpace       { InterpSpace::MODEL }; //!< interpolation space
+    InterpMode    definedMode        { InterpMode::LINEAR }; //!< interpolation mode
   };
 
-  DefinedData definedData_;
+  CowData<DefinedData> definedData_;
 
   int defaultNumColors_ { 100 };   //!< default number of colors for interp
 
-#if 0
+  // Lookup Table
+  struct LutData {
+    int     size     { 0 };     //!< number of table entries (0 for none)
+    bool    interp   { true };  //!< interpolate between entries
+    double  maxError { 0.0 };   //!< max error for automatic size (0 for none)
+    ColorFs colors;             //!< baked colors
+    double  error    { -1.0 };  //!< max error of baked colors (-1 if not measured)
+
+    std::atomic<bool> valid { false }; //!< are baked colors valid
+  };
+
+  mutable LutData lutData_;
+
+  // Color Integrals
+  struct IntegralData {
+    ColorFs colors;           //!< sampled colors (numSteps + 1 in 0-1)
+    Reals   sums;             //!< cumulative r, g, b, a integrals at each sample
+
+    std::atomic<bool> valid { false }; //!< are integrals valid
+  };
+
+  mutable IntegralData integralData_;
+
+  // Mip Levels
+  struct MipData {
+    std::vector<ColorFs> levels; //!< box filtered cell colors per level
+
+    std::atomic<bool> valid { false }; //!< are levels valid
+  };
+
+  mutable MipData mipData_;
+
+  // Evaluator
+  struct ModelChannel {
+    int    model  { 0 };   //!< model index
+    double offset { 0.0 }; //!< offset of value (min, or max if negated)
+    double scale  { 1.0 }; //!< scale of model value (max - min, negated if negative)
+  };
+
+  // batch evaluation state (members point to palette or snapshot data)
+  struct EvalData {
+    EvalProc   proc     { nullptr };          //!< evaluator for current state
+    EvalProc   baseProc { nullptr };          //!< evaluator before gamma correction
+    ColorType  type     { ColorType::MODEL }; //!< color type
+    ColorModel model    { ColorModel::RGB };  //!< color model
+
+    const CowData<DefinedData> *defined { nullptr }; //!< defined colors
+
+    ModelChannel channels[3];          //!< model red, green, blue channel
+    bool         gray       { false }; //!< is gray
+    bool         grayNegate { false }; //!< gray model negated
+
+    const GammaData *gamma { nullptr }; //!< gamma correction table
+
+    const CCubeHelix *cubeHelix    { nullptr }; //!< cube helix (table built)
+    bool              cubeNegative { false };   //!< is cube helix negated
+
+    const LutData *lut { nullptr }; //!< lookup table (nullptr if not used)
+
+    const CQColorsPalette *palette { nullptr }; //!< palette for other color types (functions)
+  };
+
+  EvalData evalData_;
+
+  // Integer Input Tables
+  struct IntTable {
+    std::vector<QRgb> colors;           //!< color for each input value
+    std::atomic<bool> valid  { false }; //!< are colors valid
+  };
+
+  static const int numIntTables = 8; //!< scale, invert and premultiplied combinations
+
+  struct IntTables {
+    IntTable   tables8 [numIntTables]; //!< tables for 8 bit values
+    IntTable   tables16[numIntTables]; //!< tables for 16 bit values
+    std::mutex mutex;                  //!< lock for building tables
+  };
+
+  mutable IntTables intTables_;
+
+  // lock for building caches in const methods (cached data is only written
+  // before valid is set, so concurrent const evaluation is race free)
+  mutable std::recursive_mutex cacheMutex_;
+
   // Misc
-  double gamma_ { 1.5 }; //!< gamma value
-#endif
+  double gamma_ { 1.0 }; //!< gamma value
+
+  // Gamma correction table
+  struct GammaData {
+    double gamma { 1.0 }; //!< gamma of table
+    Floats values;        //!< corrected values (empty if no correction)
+  };
+
+  GammaData gammaData_;
 
   QImage gradientImage_;               //!< gradient image (of size)
   bool   gradientImageDirty_ { true }; //!< is gradient image invalid
+  bool   gradientFiltered_   { false }; //!< use mip colors for minified gradient image
+  double gradientDirtyMin_   { 1.0 };  //!< min x of invalid gradient range
+  double gradientDirtyMax_   { 0.0 };  //!< max x of invalid gradient range (none if < min)
 };
 
 using CQColorsPaletteP = std::unique_ptr<CQColorsPalette>;
@@ -0,0 +1,97 @@
+#ifndef CQColorsPaletteSnapshot_H
+#define CQColorsPaletteSnapshot_H
+
+#include <CQColorsPalette.h>
+#include <CCubeHelix.h>
+#include <memory>
+
+//! \brief immutable palette evaluation data for colorizing on worker threads
+//!
+//! Plain value holding only frozen data taken from a palette: defined color stops and
+//! segment records, model channels, gamma table, cube helix parameters and table, and the
+//! baked lookup table (function palettes are always baked as they need the palette's
+//! interpreter). There is no palette (or QObject) behind it.
+//!
+//! Copies are cheap and share the same data. The data is never edited so any number of
+//! threads can evaluate it while the source palette is edited. Take a new snapshot (on the
+//! palette thread) when the palette changes (colorsChanged or colorsRangeChanged) and
+//! publish it to workers.
+class CQColorsPaletteSnapshot {
+ public:
+  using ColorType  = CQColorsPalette::ColorType;
+  using ColorModel = CQColorsPalette::ColorModel;
+  using ColorF     = CQColorsPalette::ColorF;
+
+ public:
+  CQColorsPaletteSnapshot() = default;
+
+  //! create from current state of palette (call from palette thread)
+  explicit CQColorsPaletteSnapshot(const CQColorsPalette &palette);
+
+  //! is empty (default constructed, evaluates to black)
+  bool isNull() const { return ! data_; }
+
+  //! get color type and model of palette
+  ColorType  colorType () const { return (data_ ? data_->eval.type  : ColorType ::NONE); }
+  ColorModel colorModel() const { return (data_ ? data_->eval.model : ColorModel::NONE); }
+
+  //---
+
+  //! interpolate color at x (see CQColorsPalette::getColor)
+  QColor getColor(double x, bool scale=false, bool invert=false) const;
+
+  ColorF getColorF(double x, bool scale=false, bool invert=false) const;
+
+  //! interpolate n colors at x values into caller owned array (see CQColorsPalette::getColors)
+  void getColors(const double *x, int n, QRgb *rgb, bool scale=false, bool invert=false,
+                 bool premultiplied=false) const;
+  void getColors(const float  *x, int n, QRgb *rgb, bool scale=false, bool invert=false,
+                 bool premultiplied=false) const;
+
+  void getColorsF(const double *x, int n, ColorF *c, bool scale=false, bool invert=false) const;
+  void getColorsF(const float  *x, int n, ColorF *c, bool scale=false, bool invert=false) const;
+
+  //! colorize full range integer values (0-255 or 0-65535 mapped to 0-1)
+  void getColors(const uint8_t  *v, int n, QRgb *rgb, bool scale=false, bool invert=false,
+                 bool premultiplied=false) const;
+  void getColors(const uint16_t *v, int n, QRgb *rgb, bool scale=false, bool invert=false,
+                 bool premultiplied=false) const;
+
+  //! colorize grayscale image (see CQColorsPalette::colorizeImage)
+  QImage colorizeImage(const QImage &image, bool scale=false, bool invert=false,
+                       bool premultiplied=false) const;
+
+  //! are any colors translucent
+  bool hasAlpha() const;
+
+ private:
+  using Palette = CQColorsPalette;
+
+  // evaluation data points into its own members so is never copied (shared by snapshots)
+  struct Data {
+    // Defined (stops and segment records, shared with palette until it is edited)
+    Palette::CowData<Palette::DefinedData> defined;
+
+    // Gamma correction table
+    Palette::GammaData gamma;
+
+    // CubeHelix (table built)
+    CCubeHelix cubeHelix;
+
+    // Lookup Table (baked colors, unused if evaluated exactly)
+    Palette::LutData lut;
+
+    // Evaluator (palette batch evaluation on above data)
+    Palette::EvalData eval;
+
+    // Integer Input Tables (built on first use)
+    mutable Palette::IntTables intTables;
+  };
+
+  using DataP = std::shared_ptr<const Data>;
+
+ private:
+  DataP data_; //!< shared frozen data
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef CQColorsSIMD_H
+#define CQColorsSIMD_H
+
+#include <QColor>
+
+//! \brief vectorized palette kernels (with runtime CPU dispatch)
+namespace CQColorsSIMD {
+
+enum class Level {
+  NONE,
+  SSE4,
+  AVX2
+};
+
+//! get SIMD level used by kernels (best supported by CPU, limited by max level)
+Level level();
+
+//! get/set max SIMD level to use (NONE to force scalar code)
+Level maxLevel();
+void setMaxLevel(Level level);
+
+//! float stop data
+//!
+//! positions are increasing normalized stop values and segments holds a record of
+//! eight floats per segment (n - 1 records): start x, 1/dx and then start value and
+//! delta for each of the three channels (c1, dc1, c2, dc2, c3, dc3)
+struct Stops {
+  const float *x        { nullptr }; //!< normalized positions
+  const float *segments { nullptr }; //!< segment records
+  int          n        { 0 };       //!< number of stops (at least 2)
+};
+
+//! interpolate n (normalized) x values between stops in RGB and pack to rgb array
+//! (returns false if no SIMD support)
+bool interpRGB(const Stops &stops, const float *x, int n, QRgb *rgb);
+
+//! interpolate n (normalized) x values between stops in HSV (segment channels are
+//! hue, saturation and value) and pack to rgb array (returns false if no SIMD support)
+bool interpHSV(const Stops &stops, const float *x, int n, QRgb *rgb);
+
+//! convert n hsv values (0-1) in separate h, s, v arrays to r, g, b arrays
+//! (returns false if no SIMD support)
+bool hsvToRgb(const float *h, const float *s, const float *v, int n, float *r, float *g, float *b);
+
+//! transform n color values (separate c1, c2, c3 arrays) to r, g, b arrays using affine
+//! matrix (3 rows of three scales and an offset) (returns false if no SIMD support)
+bool transformRgb(const float *matrix, const float *c1, const float *c2, const float *c3,
+                  int n, float *r, float *g, float *b);
+
+}
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef CQColorsSpace_H
+#define CQColorsSpace_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+//! \brief perceptual color space conversions (sRGB values in range 0-1, D65 white)
+namespace CQColorsSpace {
+
+//! sRGB to linear light value
+inline double srgbToLinear(double c) {
+  return (c <= 0.04045 ? c/12.92 : std::pow((c + 0.055)/1.055, 2.4));
+}
+
+//! linear light to sRGB value (exact)
+inline double linearToSrgbExact(double c) {
+  return (c <= 0.0031308 ? 12.92*c : 1.055*std::pow(c, 1.0/2.4) - 0.055);
+}
+
+//! linear light to sRGB value (interpolated from table in range 0-1, max error about 2e-5)
+inline double linearToSrgb(double c) {
+  static const int numSteps = 4096;
+
+  static const std::vector<float> table = []() {
+    std::vector<float> values(numSteps + 1);
+
+    for (int i = 0; i <= numSteps; ++i)
+      values[i] = float(linearToSrgbExact(double(i)/numSteps));
+
+    return values;
+  }();
+
+  if (! (c >= 0.0 && c <= 1.0))
+    return linearToSrgbExact(c);
+
+  double s = c*numSteps;
+
+  int i = std::min(int(s), numSteps - 1);
+
+  return table[i] + (s - i)*(table[i + 1] - table[i]);
+}
+
+//---
+
+//! sRGB to OKLab (L in range 0-1)
+inline void rgbToOKLab(double r, double g, double b, double &L, double &A, double &B) {
+  r = srgbToLinear(r); g = srgbToLinear(g); b = srgbToLinear(b);
+
+  double l = std::cbrt(0.4122214708*r + 0.5363325363*g + 0.0514459929*b);
+  double m = std::cbrt(0.2119034982*r + 0.6806995451*g + 0.1073969566*b);
+  double s = std::cbrt(0.0883024619*r + 0.2817188376*g + 0.6299787005*b);
+
+  L = 0.2104542553*l + 0.7936177850*m - 0.0040720468*s;
+  A = 1.9779984951*l - 2.4285922050*m + 0.4505937099*s;
+  B = 0.0259040371*l + 0.7827717662*m - 0.8086757660*s;
+}
+
+//! OKLab to sRGB (not clamped)
+inline void okLabToRgb(double L, double A, double B, double &r, double &g, double &b) {
+  double l = L + 0.3963377774*A + 0.2158037573*B;
+  double m = L - 0.1055613458*A - 0.0638541728*B;
+  double s = L - 0.0894841775*A - 1.2914855480*B;
+
+  l = l*l*l; m = m*m*m; s = s*s*s;
+
+  r = linearToSrgb(+4.0767416621*l - 3.3077115913*m + 0.2309699292*s);
+  g = linearToSrgb(-1.2684380046*l + 2.6097574011*m - 0.3413193965*s);
+  b = linearToSrgb(-0.0041960863*l - 0.7034186147*m + 1.7076147010*s);
+}
+
+//---
+
+//! sRGB to CIE L*a*b* (L in range 0-100)
+inline void rgbToLab(double r, double g, double b, double &L, double &A, double &B) {
+  r = srgbToLinear(r); g = srgbToLinear(g); b = srgbToLinear(b);
+
+  // XYZ normalized to D65 white
+  double x = (0.4124564*r + 0.3575761*g + 0.1804375*b)/0.95047;
+  double y = (0.2126729*r + 0.7151522*g + 0.0721750*b);
+  double z = (0.0193339*r + 0.1191920*g + 0.9503041*b)/1.08883;
+
+  auto f = [](double t) {
+    return (t > 216.0/24389.0 ? std::cbrt(t) : t*(24389.0/27.0)/116.0 + 16.0/116.0);
+  };
+
+  double fx = f(x), fy = f(y), fz = f(z);
+
+  L = 116.0*fy - 16.0;
+  A = 500.0*(fx - fy);
+  B = 200.0*(fy - fz);
+}
+
+//! CIE L*a*b* to sRGB (not clamped)
+inline void labToRgb(double L, double A, double B, double &r, double &g, double &b) {
+  double fy = (L + 16.0)/116.0;
+  double fx = fy + A/500.0;
+  double fz = fy - B/200.0;
+
+  auto finv = [](double t) {
+    return (t > 6.0/29.0 ? t*t*t : (116.0*t - 16.0)*(27.0/24389.0));
+  };
+
+  double x = 0.95047*finv(fx);
+  double y =         finv(fy);
+  double z = 1.08883*finv(fz);
+
+  r = linearToSrgb( 3.2404542*x - 1.5371385*y - 0.4985314*z);
+  g = linearToSrgb(-0.9692660*x + 1.8760108*y + 0.0415560*z);
+  b = linearToSrgb( 0.0556434*x - 0.2040259*y + 1.0572252*z);
+}
+
+//---
+
+//! CIE L*a*b* to LCh (hue in degrees 0-360)
+inline void labToLch(double L, double A, double B, double &l, double &c, double &h) {
+  l = L;
+  c = std::hypot(A, B);
+  h = std::atan2(B, A)*180.0/M_PI;
+
+  if (h < 0.0)
+    h += 360.0;
+}
+
+//! LCh (hue in degrees) to CIE L*a*b*
+inline void lchToLab(double l, double c, double h, double &L, double &A, double &B) {
+  double a = h*M_PI/180.0;
+
+  L = l;
+  A = c*std::cos(a);
+  B = c*std::sin(a);
+}
+
+}
+
+#endif
@@ -18,9 +18,11 @@ CONFIG += c++17
 SOURCES += \
 CQColors.cpp \
 CQColorsPalette.cpp \
+CQColorsPaletteSnapshot.cpp \
 CQColorsTheme.cpp \
 CQColorsDefPalettes.cpp \
 CQColorsDefThemes.cpp \
+CQColorsSIMD.cpp \
 \
 CQColorsEditCanvas.cpp \
 CQColorsEditControl.cpp \
@@ -35,7 +37,10 @@ HEADERS += \
 ../include/CQColorsDefThemes.h \
 ../include/CQColors.h \
 ../include/CQColorsPalette.h \
+../include/CQColorsPaletteSnapshot.h \
 ../include/CQColorsTheme.h \
+../include/CQColorsSIMD.h \
+../include/CQColorsSpace.h \
 \
 ../include/CQColorsEditCanvas.h \
 ../include/CQColorsEditControl.h \
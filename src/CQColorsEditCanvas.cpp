@@ -13,6 +13,8 @@
 #include <QPainter>
 #include <QPainterPath>
 
+#include <cmath>
+
 namespace Util {
   inline double rgbToGray(double r, double g, double b) {
     return r*0.3 + g*0.59 + b*0.11;
@@ -65,13 +67,19 @@ void
 CQColorsEditCanvas::
 setPalette(CQColorsPalette *palette)
 {
-  if (palette_)
+  if (palette_) {
     disconnect(palette_, SIGNAL(colorsChanged()), this, SLOT(updateSlot()));
+    disconnect(palette_, SIGNAL(colorsRangeChanged(double, double)),
+               this, SLOT(updateRangeSlot(double, double)));
+  }
 
   palette_ = palette;
 
-  if (palette_)
+  if (palette_) {
     connect(palette_, SIGNAL(colorsChanged()), this, SLOT(updateSlot()));
+    connect(palette_, SIGNAL(colorsRangeChanged(double, double)),
+            this, SLOT(updateRangeSlot(double, double)));
+  }
 
   update();
 }
@@ -161,6 +169,7 @@ mouseMoveEvent(QMouseEvent *me)
   //---
 
   if (pal->colorType() == CQColorsPalette::ColorType::DEFINED) {
+    // moved color repaints changed range (see updateRangeSlot)
     if (mouseData_.pressed) {
       double dy = mouseData_.movePos.y() - mouseData_.pressPos.y();
 
@@ -173,9 +182,9 @@ mouseMoveEvent(QMouseEvent *me)
 
       if (nearestData.i != nearestData_.i || nearestData.c != nearestData_.c)
         nearestData_ = nearestData;
-    }
 
-    update();
+      update();
+    }
   }
 }
 
@@ -416,15 +425,18 @@ nearestDefinedColor(const QPointF &p, NearestData &nearestData)
   if (! pal)
     return;
 
-  int i = 0;
+  const auto &xvalues = pal->definedStopXValues();
+  const auto &colors  = pal->definedStopColors();
 
-  for (const auto &c : pal->definedValueColors()) {
-    double x = pal->mapDefinedColorX(c.first);
+  int nc = pal->numDefinedColors();
+
+  for (int i = 0; i < nc; ++i) {
+    double x = xvalues[size_t(i)];
 
     if (pal->isInverted())
       x = 1.0 - x;
 
-    const auto &c1 = c.second;
+    const auto &c1 = colors[size_t(i)];
 
     if (! isGray()) {
       double y[3];
@@ -465,8 +477,6 @@ nearestDefinedColor(const QPointF &p, NearestData &nearestData)
         nearestData.color = c1;
       }
     }
-
-    ++i;
   }
 }
 
@@ -530,7 +540,7 @@ moveNearestDefinedColor(const NearestData &nearestData, double dy)
 
   pal->setDefinedColor(nearestData.i, newColor);
 
-  emit colorsChanged();
+  emit definedColorChanged(nearestData.i);
 }
 
 void
@@ -562,7 +572,35 @@ updateSlot()
 
 void
 CQColorsEditCanvas::
-paintEvent(QPaintEvent *)
+updateRangeSlot(double xmin, double xmax)
+{
+  // repaint columns (value curves) and rows (color bar) of changed range
+  double px1, py1, px2, py2;
+
+  windowToPixel(xmin, xmin, px1, py1);
+  windowToPixel(xmax, xmax, px2, py2);
+
+  double pxp1, pxp2;
+
+  colorBarPixelRange(pxp1, pxp2);
+
+  update(QRect(int(px1) - 4, 0, int(px2 - px1) + 9, height()));
+  update(QRect(int(pxp1) - 4, int(py2) - 4, int(pxp2 - pxp1) + 9, int(py1 - py2) + 9));
+}
+
+void
+CQColorsEditCanvas::
+colorBarPixelRange(double &pxp1, double &pxp2) const
+{
+  double py;
+
+  windowToPixel(1.05, 0.0, pxp1, py);
+  windowToPixel(1.15, 0.0, pxp2, py);
+}
+
+void
+CQColorsEditCanvas::
+paintEvent(QPaintEvent *e)
 {
   QPainter painter(this);
 
@@ -698,13 +736,23 @@ paintEvent(QPaintEvent *)
     bool   first = true;
   //double r1 = 0.0, g1 = 0.0, b1 = 0.0, m1 = 0.0, x1 = 0.0;
 
+    // only sample columns in repainted region (plus one each side to join path to
+    // unchanged curve)
+    auto rect = e->region().intersected(QRect(int(px1) - 1, 0, int(px2 - px1) + 3, height())).
+                  boundingRect();
+
+    double lx1 = px1 + std::max(std::floor(rect.left() - 1 - px1), 0.0);
+    double lx2 = std::min(double(rect.right() + 2), px2);
+
+    CQColorsPalette::Sampler sampler(pal);
+
     // get rgb (red, green, blue, gray), or hsv (hue, saturation, value, gray) paths
-    for (double x = px1; x <= px2; x += 1.0) {
+    for (double x = lx1; x <= lx2; x += 1.0) {
       double wx, wy;
 
       pixelToWindow(x, 0, wx, wy);
 
-      auto c = pal->getColor(std::min(std::max(wx, 0.0), 1.0));
+      auto c = sampler.getColor(std::min(std::max(wx, 0.0), 1.0));
 
       double x2 = wx;
 
@@ -764,22 +812,27 @@ paintEvent(QPaintEvent *)
 
   // draw color bar
   if (isShowColorBar()) {
-    double xp1 = 1.05;
-    double xp2 = 1.15;
-
     double pxp1, pxp2;
 
-    windowToPixel(xp1, 0.0, pxp1, py1);
-    windowToPixel(xp2, 1.0, pxp2, py2);
+    colorBarPixelRange(pxp1, pxp2);
 
     // draw gradient
     if (! pal->isDistinct()) {
-      for (double y = py2; y <= py1; y += 1.0) {
+      // only sample rows in repainted region
+      auto rect = e->region().intersected(QRect(int(pxp1), 0, int(pxp2 - pxp1) + 1, height())).
+                    boundingRect();
+
+      double gy1 = py2 + std::max(std::floor(rect.top() - 1 - py2), 0.0);
+      double gy2 = std::min(double(rect.bottom() + 2), py1);
+
+      CQColorsPalette::Sampler sampler(pal);
+
+      for (double y = gy1; y <= gy2; y += 1.0) {
         double wx, wy;
 
         pixelToWindow(0, y, wx, wy);
 
-        auto c = pal->getColor(wy);
+        auto c = sampler.getColor(wy);
 
         QPen pen(c); pen.setWidth(0);
 
@@ -848,15 +901,18 @@ paintEvent(QPaintEvent *)
   // draw color points
   if (isShowPoints()) {
     if (pal->colorType() == CQColorsPalette::ColorType::DEFINED) {
-      int i = 0;
+      const auto &xvalues = pal->definedStopXValues();
+      const auto &colors  = pal->definedStopColors();
+
+      int nc = pal->numDefinedColors();
 
-      for (const auto &c : pal->definedValueColors()) {
-        double x = pal->mapDefinedColorX(c.first);
+      for (int i = 0; i < nc; ++i) {
+        double x = xvalues[size_t(i)];
 
         if (pal->isInverted())
           x = 1.0 - x;
 
-        auto c1 = c.second;
+        const auto &c1 = colors[size_t(i)];
 
         if (pal->colorModel() == CQColorsPalette::ColorModel::HSV) {
           drawSymbol(&painter, x, c1.hueF       (), redPen  );
@@ -899,8 +955,6 @@ paintEvent(QPaintEvent *)
             else if (nearestData_.c == 2) drawEllipse(x, c1.blueF ());
           }
         }
-
-        ++i;
       }
     }
   }
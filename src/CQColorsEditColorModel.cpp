@@ -9,6 +9,9 @@ CQColorsEditColorModel(QWidget *parent) :
 
   addItem("RGB", QVariant(static_cast<int>(CQColorsPalette::ColorModel::RGB)));
   addItem("HSV", QVariant(static_cast<int>(CQColorsPalette::ColorModel::HSV)));
+  addItem("CMY", QVariant(static_cast<int>(CQColorsPalette::ColorModel::CMY)));
+  addItem("YIQ", QVariant(static_cast<int>(CQColorsPalette::ColorModel::YIQ)));
+  addItem("XYZ", QVariant(static_cast<int>(CQColorsPalette::ColorModel::XYZ)));
 }
 
 CQColorsPalette::ColorModel
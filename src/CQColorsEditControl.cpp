@@ -348,7 +348,8 @@ CQColorsEditControl(CQColorsEditCanvas *canvas) :
 
   connect(this, SIGNAL(stateChanged()), canvas, SLOT(update()));
 
-  connect(canvas, SIGNAL(colorsChanged()), this, SLOT(updateState()));
+  // only edited defined color row needs update on drag (palette state is unchanged)
+  connect(canvas, SIGNAL(definedColorChanged(int)), this, SLOT(updateDefinedColor(int)));
 
   //---
 
@@ -407,6 +408,16 @@ updateDefinedState()
   removeColorButton_->setEnabled(! definedColors_->selectedItems().empty());
 }
 
+void
+CQColorsEditControl::
+updateDefinedColor(int i)
+{
+  auto *pal = canvas_->palette();
+  if (! pal) return;
+
+  definedColors_->updateColor(pal, i);
+}
+
 void
 CQColorsEditControl::
 colorTypeChanged(int)
@@ -558,46 +569,41 @@ updateColorModel()
 {
   auto colorModel = this->colorModel();
 
-  if      (colorModel == CQColorsPalette::ColorModel::RGB) {
-    if (colorModel_)
-      colorModel_->setCurrentIndex(0);
-
-    redModelLabel_  ->setText("R");
-    greenModelLabel_->setText("G");
-    blueModelLabel_ ->setText("B");
-
-    modelRNegativeCheck_->setText("R");
-    modelGNegativeCheck_->setText("G");
-    modelBNegativeCheck_->setText("B");
-
-    redMinMaxLabel_  ->setText("R");
-    greenMinMaxLabel_->setText("G");
-    blueMinMaxLabel_ ->setText("B");
-
-    redFunctionLabel_  ->setText("R");
-    greenFunctionLabel_->setText("G");
-    blueFunctionLabel_ ->setText("B");
-  }
-  else if (colorModel == CQColorsPalette::ColorModel::HSV) {
-    if (colorModel_)
-      colorModel_->setCurrentIndex(1);
-
-    redModelLabel_  ->setText("H");
-    greenModelLabel_->setText("S");
-    blueModelLabel_ ->setText("V");
-
-    modelRNegativeCheck_->setText("H");
-    modelGNegativeCheck_->setText("S");
-    modelBNegativeCheck_->setText("V");
-
-    redMinMaxLabel_  ->setText("H");
-    greenMinMaxLabel_->setText("S");
-    blueMinMaxLabel_ ->setText("V");
+  if (colorModel == CQColorsPalette::ColorModel::NONE)
+    return;
 
-    redFunctionLabel_  ->setText("H");
-    greenFunctionLabel_->setText("S");
-    blueFunctionLabel_ ->setText("V");
-  }
+  if (colorModel_)
+    colorModel_->setModel(colorModel);
+
+  // set channel labels for model
+  auto setLabels = [&](const QString &l1, const QString &l2, const QString &l3) {
+    redModelLabel_  ->setText(l1);
+    greenModelLabel_->setText(l2);
+    blueModelLabel_ ->setText(l3);
+
+    modelRNegativeCheck_->setText(l1);
+    modelGNegativeCheck_->setText(l2);
+    modelBNegativeCheck_->setText(l3);
+
+    redMinMaxLabel_  ->setText(l1);
+    greenMinMaxLabel_->setText(l2);
+    blueMinMaxLabel_ ->setText(l3);
+
+    redFunctionLabel_  ->setText(l1);
+    greenFunctionLabel_->setText(l2);
+    blueFunctionLabel_ ->setText(l3);
+  };
+
+  if      (colorModel == CQColorsPalette::ColorModel::HSV)
+    setLabels("H", "S", "V");
+  else if (colorModel == CQColorsPalette::ColorModel::CMY)
+    setLabels("C", "M", "Y");
+  else if (colorModel == CQColorsPalette::ColorModel::YIQ)
+    setLabels("Y", "I", "Q");
+  else if (colorModel == CQColorsPalette::ColorModel::XYZ)
+    setLabels("X", "Y", "Z");
+  else
+    setLabels("R", "G", "B");
 }
 
 int
@@ -764,12 +770,13 @@ addColorSlot()
   if (selectedItems.length())
     row = selectedItems[0]->row();
 
-  const auto &colors = pal->definedValueColors();
+  const auto &values = pal->definedStopValues();
+  const auto &colors = pal->definedStopColors();
 
   double x = 0.5;
   auto   c = QColor(127, 127, 127);
 
-  auto nc = CUtil::toInt(colors.size());
+  auto nc = pal->numDefinedColors();
 
   int row1 = -1;
 
@@ -779,16 +786,13 @@ addColorSlot()
     row1 = row - 1;
 
   if (row1 >= 0) {
-    auto p = colors.begin();
-
-    std::advance(p, row1);
+    auto i1 = size_t(row1);
 
-    double      x1 = (*p).first;
-    const auto &c1 = (*p).second;
+    double      x1 = values[i1];
+    const auto &c1 = colors[i1];
 
-    ++p;
-    double      x2 = (*p).first;
-    const auto &c2 = (*p).second;
+    double      x2 = values[i1 + 1];
+    const auto &c2 = colors[i1 + 1];
 
     x = (x1 + x2)/2;
 
@@ -799,10 +803,8 @@ addColorSlot()
   }
   else {
     if (nc == 1) {
-      auto p = colors.begin();
-
-      double      x1 = (*p).first;
-      const auto &c1 = (*p).second;
+      double      x1 = values[0];
+      const auto &c1 = colors[0];
 
       if (x1 != 1.0)
         x = (x1 + 1.0)/2;
@@ -837,20 +839,10 @@ removeColorSlot()
 
   int row = selectedItems[0]->row();
 
-  auto colors = pal->definedValueColors();
-
-  CQColorsPalette::ColorMap colors1;
-
-  int i = 0;
-
-  for (const auto &pc : colors) {
-    if (i != row)
-      colors1[pc.first] = pc.second;
-
-    ++i;
-  }
+  if (row < 0 || row >= pal->numDefinedColors())
+    return;
 
-  pal->setDefinedColors(colors1);
+  pal->removeDefinedColor(row);
 
   definedColors_->updateColors(pal);
 
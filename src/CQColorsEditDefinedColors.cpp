@@ -76,8 +76,13 @@ updateColors(CQColorsPalette *canvas)
 
   realColors_.clear();
 
-  for (const auto &c : canvas->definedValueColors())
-    realColors_.emplace_back(c.first, c.second.rgba());
+  const auto &values = canvas->definedStopValues();
+  const auto &colors = canvas->definedStopColors();
+
+  realColors_.reserve(values.size());
+
+  for (size_t i = 0; i < values.size(); ++i)
+    realColors_.emplace_back(values[i], colors[i].rgba());
 
   for (int r = 0; r < CUtil::toInt(numRealColors()); ++r) {
     const auto &realColor = this->realColor(r);
@@ -90,6 +95,21 @@ updateColors(CQColorsPalette *canvas)
   }
 }
 
+void
+CQColorsEditDefinedColors::
+updateColor(CQColorsPalette *palette, int r)
+{
+  if (r < 0 || r >= rowCount() || r >= CUtil::toInt(numRealColors()))
+    return;
+
+  auto &realColor = realColors_[size_t(r)];
+
+  realColor = RealColor(palette->definedColorValue(r), palette->definedColor(r).rgba());
+
+  if (item(r, 0)) item(r, 0)->setText(QString("%1").arg(realColor.r));
+  if (item(r, 1)) item(r, 1)->setText(realColor.c.name());
+}
+
 const CQColorsEditDefinedColors::RealColor &
 CQColorsEditDefinedColors::
 realColor(int r) const
@@ -1,4 +1,6 @@
 #include <CQColorsPalette.h>
+#include <CQColorsSIMD.h>
+#include <CQColorsSpace.h>
 #include <CCubeHelix.h>
 #ifdef CQCOLORS_TCL
 #include <CQTclUtil.h>
@@ -7,12 +9,263 @@
 #include <QLinearGradient>
 #include <QPainter>
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <type_traits>
+
+namespace {
+
+inline int toByte(double r) {
+  return int(CMathUtil::clamp(r, 0.0, 1.0)*255.0 + 0.5);
+}
+
+inline QRgb packRGB(double r, double g, double b, double a=1.0) {
+  return qRgba(toByte(r), toByte(g), toByte(b), toByte(a));
+}
+
+inline quint16 toShort(double r) {
+  return quint16(CMathUtil::clamp(r, 0.0, 1.0)*65535.0 + 0.5);
+}
+
+// store color in batch output (packed 8 bit, float or 16 bit)
+inline void storeColor(QRgb &rgb, double r, double g, double b, double a=1.0) {
+  rgb = packRGB(r, g, b, a);
+}
+
+inline void storeColor(CQColorsPalette::ColorF &c, double r, double g, double b, double a=1.0) {
+  c.r = float(CMathUtil::clamp(r, 0.0, 1.0));
+  c.g = float(CMathUtil::clamp(g, 0.0, 1.0));
+  c.b = float(CMathUtil::clamp(b, 0.0, 1.0));
+  c.a = float(CMathUtil::clamp(a, 0.0, 1.0));
+}
+
+inline void storeColor(QRgba64 &c, double r, double g, double b, double a=1.0) {
+  c = QRgba64::fromRgba64(toShort(r), toShort(g), toShort(b), toShort(a));
+}
+
+inline void storeColor(QRgb &rgb, const QColor &c) {
+  rgb = c.rgba();
+}
+
+template<typename C>
+inline void storeColor(C &c, const QColor &qc) {
+  qreal r, g, b, a;
+
+  qc.getRgbF(&r, &g, &b, &a);
+
+  storeColor(c, r, g, b, a);
+}
+
+//---
+
+// scalar float versions of vector color conversion kernels (same float operations so same
+// results, see CQColorsSIMD::hsvToRgb and CQColorsSIMD::transformRgb)
+inline void hsvToRgbF(float h, float s, float v, float &r, float &g, float &b) {
+  float h6 = h*6.0f;
+
+  // hue of 1.0 is same as 0.0
+  if (h6 >= 6.0f)
+    h6 = 0.0f;
+
+  float i = std::floor(h6);
+  float f = h6 - i;
+
+  float p = v*(1.0f - s);
+  float q = v*(1.0f - s*f);
+  float t = v*(1.0f - s*(1.0f - f));
+
+  auto select6 = [&](float v0, float v1, float v2, float v3, float v4, float v5) {
+    return (i == 1.0f ? v1 : i == 2.0f ? v2 : i == 3.0f ? v3 :
+            i == 4.0f ? v4 : i == 5.0f ? v5 : v0);
+  };
+
+  r = select6(v, q, p, p, t, v);
+  g = select6(t, v, v, q, p, p);
+  b = select6(p, p, t, v, v, q);
+}
+
+inline float matrixRow(const float *m, float c1, float c2, float c3) {
+  float res = m[3];
+
+  res = res + m[0]*c1;
+  res = res + m[1]*c2;
+  res = res + m[2]*c3;
+
+  return res;
+}
+
+inline void matrixToRgbF(const float *m, float c1, float c2, float c3,
+                         float &r, float &g, float &b) {
+  r = matrixRow(m    , c1, c2, c3);
+  g = matrixRow(m + 4, c1, c2, c3);
+  b = matrixRow(m + 8, c1, c2, c3);
+}
+
+//---
+
+// monotone cubic (Fritsch-Carlson) coefficients (c0 + c1*t + c2*t^2 + c3*t^3 for t in
+// 0-1) per channel for each segment of linear segment records (see CQColorsSIMD::Stops)
+void cubicCoeffs(const CQColorsPalette::Reals &x, const CQColorsPalette::Floats &segments,
+                 CQColorsPalette::Floats &coeffs) {
+  auto ns = segments.size()/8;
+
+  coeffs.resize(12*ns);
+
+  std::vector<double> secants(ns), tangents(ns + 1);
+
+  for (int k = 0; k < 3; ++k) {
+    // segment slopes
+    for (size_t i = 0; i < ns; ++i) {
+      double dx = x[i + 1] - x[i];
+
+      secants[i] = (dx > 0.0 ? segments[8*i + 3 + 2*k]/dx : 0.0);
+    }
+
+    // end tangent from (shape preserving) three point formula
+    auto endTangent = [&](double h1, double h2, double d1, double d2) {
+      if (h1 + h2 <= 0.0)
+        return d1;
+
+      double t = ((2*h1 + h2)*d1 - h1*d2)/(h1 + h2);
+
+      if      (t*d1 <= 0.0)
+        t = 0.0;
+      else if (d1*d2 <= 0.0 && std::abs(t) > std::abs(3*d1))
+        t = 3*d1;
+
+      return t;
+    };
+
+    // stop tangents (zero at extrema, weighted harmonic mean of slopes otherwise)
+    for (size_t i = 0; i <= ns; ++i) {
+      if      (ns < 2)
+        tangents[i] = (ns > 0 ? secants[0] : 0.0);
+      else if (i == 0)
+        tangents[i] = endTangent(x[1] - x[0], x[2] - x[1], secants[0], secants[1]);
+      else if (i == ns)
+        tangents[i] = endTangent(x[ns] - x[ns - 1], x[ns - 1] - x[ns - 2],
+                                 secants[ns - 1], secants[ns - 2]);
+      else {
+        double d1 = secants[i - 1];
+        double d2 = secants[i];
+
+        if (d1*d2 <= 0.0) {
+          tangents[i] = 0.0;
+          continue;
+        }
+
+        double h1 = x[i] - x[i - 1];
+        double h2 = x[i + 1] - x[i];
+
+        double w1 = 2*h2 + h1;
+        double w2 = h2 + 2*h1;
+
+        tangents[i] = (w1 + w2)/(w1/d1 + w2/d2);
+      }
+    }
+
+    // hermite coefficients for t in 0-1
+    for (size_t i = 0; i < ns; ++i) {
+      double dx = x[i + 1] - x[i];
+
+      double p0 = segments[8*i + 2 + 2*k];
+      double dp = segments[8*i + 3 + 2*k];
+
+      double t0 = tangents[i    ]*dx;
+      double t1 = tangents[i + 1]*dx;
+
+      auto *c = &coeffs[12*i + 4*k];
+
+      c[0] = float(p0);
+      c[1] = float(t0);
+      c[2] = float( 3*dp - 2*t0 - t1);
+      c[3] = float(-2*dp +   t0 + t1);
+    }
+  }
+}
+
+//---
+
+// gamma correction table steps (in range 0-1)
+const int gammaSteps = 4096;
+
+// color integral steps (in range 0-1)
+const int integralSteps = 1024;
+
+// lookup table error test points and max automatic size
+const int lutTestSteps = 8192;
+const int maxLutSize   = 8193;
+
+// finest mip level cells (in range 0-1, power of two)
+const int mipSize = 512;
+
+//---
+
+// rgbformulae model values sampled at numSteps + 1 points in 0-1 (built on first use)
+class ModelTable {
+ public:
+  static const ModelTable &instance() {
+    static ModelTable table;
+
+    return table;
+  }
+
+  double value(int ind, double x) const {
+    // inverted model is same table read in reverse
+    if (ind < 0) {
+      ind = -ind;
+      x   = 1.0 - x;
+    }
+
+    if (ind >= numModels_)
+      return CQColorsPalette::interpModel(ind, x);
+
+    double s = x*numSteps;
+
+    int i = (s > 0.0 ? std::min(int(s), numSteps - 1) : 0);
+
+    // roots (sqrt(x), sqrt(sqrt(x))) have infinite slope at zero so calc first step
+    if (i == 0 && (ind == 7 || ind == 8))
+      return CQColorsPalette::interpModel(ind, x);
+
+    const auto *v = &values_[size_t(ind)*(numSteps + 1) + i];
+
+    return v[0] + (s - i)*(v[1] - v[0]);
+  }
+
+ private:
+  ModelTable() {
+    numModels_ = CQColorsPalette::numModels();
+
+    values_.resize(size_t(numModels_)*(numSteps + 1));
+
+    auto *v = values_.data();
+
+    for (int ind = 0; ind < numModels_; ++ind) {
+      for (int i = 0; i <= numSteps; ++i)
+        *v++ = float(CQColorsPalette::interpModel(ind, double(i)/numSteps));
+    }
+  }
+
+ private:
+  static const int numSteps = 4096;
+
+  int                numModels_ { 0 };
+  std::vector<float> values_;
+};
+
+}
 
 CQColorsPalette::
 CQColorsPalette()
 {
+  // created up front so const access never allocates
+  cubeHelix_ = new CCubeHelix;
+
   init();
+
+  updateEvaluator();
 }
 
 void
@@ -35,10 +288,6 @@ CQColorsPalette::
 ~CQColorsPalette()
 {
   delete cubeHelix_;
-
-#ifdef CQCOLORS_TCL
-  delete qtcl_;
-#endif
 }
 
 #if 0
@@ -62,29 +311,20 @@ assign(const CQColorsPalette &palette)
   colorType_  = palette.colorType_;
   colorModel_ = palette.colorModel_;
 
-  // Color Model
+  // Color Model (shared until edited)
   modelData_ = palette.modelData_;
 
   // Functions
   tclFnData_ = palette.tclFnData_;
 
   // CubeHelix
-  if (palette.cubeHelix_) {
-    cubeHelix_ = new CCubeHelix;
-
-    *cubeHelix_ = *palette.cubeHelix_;
-  }
-  else {
-    delete cubeHelix_;
-
-    cubeHelix_ = nullptr;
-  }
+  *cubeHelix_ = *palette.cubeHelix_;
 
   cubeNegative_ = palette.cubeNegative_;
 
   //---
 
-  // Defined
+  // Defined (shared until edited)
   definedData_ = palette.definedData_;
 
   //---
@@ -92,26 +332,19 @@ assign(const CQColorsPalette &palette)
   // Misc
   defaultNumColors_ = palette.defaultNumColors_;
 
-#if 0
-  gamma_= palette.gamma_;
-#endif
-
-#ifdef CQCOLORS_TCL
-  // Tcl
-  delete qtcl_;
-
-  qtcl_ = nullptr;
-#endif
+  // Lookup Table
+  lutData_.size     = palette.lutData_.size;
+  lutData_.interp   = palette.lutData_.interp;
+  lutData_.maxError = palette.lutData_.maxError;
 
-  //---
+  gamma_ = palette.gamma_;
 
-  init();
+  // Gradient Image
+  gradientFiltered_ = palette.gradientFiltered_;
 
   //---
 
-  emit colorsChanged();
-
-  gradientImageDirty_ = true;
+  invalidate();
 }
 
 CQColorsPalette *
@@ -132,15 +365,17 @@ CQTcl *
 CQColorsPalette::
 qtcl() const
 {
-  if (! qtcl_) {
-    auto *th = const_cast<CQColorsPalette *>(this);
+  // functions only use the gray variable (set for each evaluation) so one
+  // interpreter per thread can be shared by all palettes
+  thread_local std::unique_ptr<CQTcl> qtcl;
 
-    th->qtcl_ = new CQTcl;
+  if (! qtcl) {
+    qtcl = std::make_unique<CQTcl>();
 
-    th->qtcl_->createVar("pi", M_PI);
+    qtcl->createVar("pi", M_PI);
   }
 
-  return qtcl_;
+  return qtcl.get();
 }
 #endif
 
@@ -162,6 +397,8 @@ CQColorsPalette::
 setRedFunction(const std::string &fn)
 {
   tclFnData_.rf.fn = fn;
+
+  invalidate();
 }
 
 void
@@ -169,6 +406,8 @@ CQColorsPalette::
 setGreenFunction(const std::string &fn)
 {
   tclFnData_.gf.fn = fn;
+
+  invalidate();
 }
 
 void
@@ -176,6 +415,8 @@ CQColorsPalette::
 setBlueFunction(const std::string &fn)
 {
   tclFnData_.bf.fn = fn;
+
+  invalidate();
 }
 
 void
@@ -213,7 +454,9 @@ void
 CQColorsPalette::
 setCbStart(double r)
 {
-  cubeHelix()->setStart(r);
+  cubeHelix_->setStart(r);
+
+  invalidate();
 }
 
 double
@@ -227,7 +470,9 @@ void
 CQColorsPalette::
 setCbCycles(double r)
 {
-  cubeHelix()->setCycles(r);
+  cubeHelix_->setCycles(r);
+
+  invalidate();
 }
 
 double
@@ -241,7 +486,9 @@ void
 CQColorsPalette::
 setCbSaturation(double r)
 {
-  cubeHelix()->setSaturation(r);
+  cubeHelix_->setSaturation(r);
+
+  invalidate();
 }
 
 bool
@@ -256,18 +503,14 @@ CQColorsPalette::
 setCubeNegative(bool b)
 {
   cubeNegative_ = b;
+
+  invalidate();
 }
 
-CCubeHelix *
+const CCubeHelix *
 CQColorsPalette::
 cubeHelix() const
 {
-  if (! cubeHelix_) {
-    auto *th = const_cast<CQColorsPalette *>(this);
-
-    th->cubeHelix_ = new CCubeHelix;
-  }
-
   return cubeHelix_;
 }
 
@@ -279,9 +522,13 @@ setRgbModel(int r, int g, int b)
 {
   colorType_ = ColorType::MODEL;
 
-  modelData_.rModel = r;
-  modelData_.gModel = g;
-  modelData_.bModel = b;
+  auto &modelData = modelData_.edit();
+
+  modelData.rModel = r;
+  modelData.gModel = g;
+  modelData.bModel = b;
+
+  invalidate();
 }
 
 //---
@@ -290,28 +537,46 @@ int
 CQColorsPalette::
 numDefinedColors() const
 {
-  return int(definedData_.definedColors.size());
+  return int(definedData_->definedValues.size());
 }
 
 CQColorsPalette::DefinedColors
 CQColorsPalette::
 definedColors() const
 {
-  return definedData_.definedColors;
+  const auto &values = definedData_->definedValues;
+  const auto &colors = definedData_->definedColors;
+
+  DefinedColors dcolors;
+
+  dcolors.reserve(values.size());
+
+  for (size_t i = 0; i < values.size(); ++i)
+    dcolors.push_back(DefinedColor(values[i], colors[i]));
+
+  return dcolors;
 }
 
 CQColorsPalette::ColorMap
 CQColorsPalette::
 definedValueColors() const
 {
-  return definedData_.definedValueColors;
+  const auto &values = definedData_->definedValues;
+  const auto &colors = definedData_->definedColors;
+
+  ColorMap cmap;
+
+  for (size_t i = 0; i < values.size(); ++i)
+    cmap.emplace_hint(cmap.end(), values[i], colors[i]);
+
+  return cmap;
 }
 
 QColor
 CQColorsPalette::
 definedColor(int i) const
 {
-  auto nc = definedData_.definedColors.size();
+  auto nc = definedData_->definedColors.size();
   assert(i >= 0 && i < int(nc));
 
   if (isInverted()) i = int(nc - 1 - size_t(i));
@@ -323,7 +588,7 @@ double
 CQColorsPalette::
 definedColorValue(int i) const
 {
-  auto nc = definedData_.definedColors.size();
+  auto nc = definedData_->definedColors.size();
   assert(i >= 0 && i < int(nc));
 
   if (isInverted()) i = int(nc - 1 - size_t(i));
@@ -335,14 +600,17 @@ CQColorsPalette::DefinedColor
 CQColorsPalette::
 definedColorData(int i) const
 {
-  return definedData_.definedColors[size_t(i)];
+  return DefinedColor(definedData_->definedValues[size_t(i)],
+                      definedData_->definedColors[size_t(i)]);
 }
 
 bool
 CQColorsPalette::
 isDefinedColor(double v) const
 {
-  return (definedData_.definedValueColors.find(v) != definedData_.definedValueColors.end());
+  const auto &values = definedData_->definedValues;
+
+  return std::binary_search(values.begin(), values.end(), v);
 }
 
 void
@@ -351,23 +619,123 @@ addDefinedColor(double v, const QColor &c)
 {
   assert(! isDefinedColor(v));
 
-  definedData_.definedColors.push_back(DefinedColor(v, c));
+  auto &definedData = definedData_.edit();
+
+  // insert at value order position
+  auto &values = definedData.definedValues;
+  auto &colors = definedData.definedColors;
+
+  auto p = std::lower_bound(values.begin(), values.end(), v);
+  auto k = std::distance(values.begin(), p);
+
+  values.insert(p, v);
+  colors.insert(colors.begin() + k, c);
+
+  bool rescale = (values.front() != definedData.definedMin ||
+                  values.back () != definedData.definedMax);
+
+  definedData.definedMin = values.front();
+  definedData.definedMax = values.back ();
+
+  // only rebuild segments either side of new color
+  if (values.size() > 2)
+    updateDefinedInsert(size_t(k), rescale);
+  else
+    updateDefinedValues();
+
+  invalidate();
+}
+
+void
+CQColorsPalette::
+addDefinedColors(const DefinedColors &colors)
+{
+  auto &definedData = definedData_.edit();
+
+  auto &values  = definedData.definedValues;
+  auto &dcolors = definedData.definedColors;
+
+  // merge new colors into value order
+  DefinedColors colors1;
+
+  colors1.reserve(values.size() + colors.size());
+
+  for (size_t i = 0; i < values.size(); ++i)
+    colors1.push_back(DefinedColor(values[i], dcolors[i]));
+
+  for (const auto &c : colors)
+    colors1.push_back(c);
+
+  std::stable_sort(colors1.begin(), colors1.end(),
+    [](const DefinedColor &lhs, const DefinedColor &rhs) { return lhs.v < rhs.v; });
+
+  auto n = colors1.size();
+
+  values .resize(n);
+  dcolors.resize(n);
+
+  for (size_t i = 0; i < n; ++i) {
+    assert(i == 0 || colors1[i].v != colors1[i - 1].v);
+
+    values [i] = colors1[i].v;
+    dcolors[i] = colors1[i].c;
+  }
+
+  definedData.definedMin = (n > 0 ? values.front() : 0.0);
+  definedData.definedMax = (n > 0 ? values.back () : 0.0);
+
+  // single rebuild for all colors
+  updateDefinedValues();
+
+  invalidate();
+}
+
+void
+CQColorsPalette::
+removeDefinedColor(int i)
+{
+  assert(i >= 0 && i < numDefinedColors());
+
+  auto &definedData = definedData_.edit();
+
+  auto &values = definedData.definedValues;
+  auto &colors = definedData.definedColors;
 
-  definedData_.definedValueColors[v] = c;
+  values.erase(values.begin() + i);
+  colors.erase(colors.begin() + i);
 
-  definedData_.definedMin = definedData_.definedValueColors. begin()->first;
-  definedData_.definedMax = definedData_.definedValueColors.rbegin()->first;
+  double xmin = (! values.empty() ? values.front() : 0.0);
+  double xmax = (! values.empty() ? values.back () : 0.0);
+
+  bool rescale = (xmin != definedData.definedMin || xmax != definedData.definedMax);
+
+  definedData.definedMin = xmin;
+  definedData.definedMax = xmax;
+
+  // only rebuild segment joining colors either side of removed color
+  if (values.size() > 1)
+    updateDefinedRemove(size_t(i), rescale);
+  else
+    updateDefinedValues();
+
+  invalidate();
 }
 
 void
 CQColorsPalette::
 resetDefinedColors()
 {
-  definedData_.definedColors     .clear();
-  definedData_.definedValueColors.clear();
+  auto &definedData = definedData_.edit();
+
+  definedData.definedValues.clear();
+  definedData.definedColors.clear();
+
+  definedData.definedMin = 0.0;
+  definedData.definedMax = 0.0;
+
+  updateDefinedValues();
 
-  definedData_.definedMin = 0.0;
-  definedData_.definedMax = 0.0;
+  invalidate();
 }
 
 void
@@ -376,293 +744,2232 @@ setDefinedColor(int i, const QColor &c)
 {
   assert(i >= 0 && i < numDefinedColors());
 
-  auto &dc = definedData_.definedColors[size_t(i)];
+  auto &definedData = definedData_.edit();
+
+  auto k = size_t(i);
+
+  definedData.definedColors[k] = c;
+
+  //---
+
+  // update segments either side of color
+  const auto &xvalues = definedData.definedXValues;
+
+  auto n = xvalues.size();
+
+  if (k > 0    ) updateDefinedSegment(k - 1);
+  if (k + 1 < n) updateDefinedSegment(k);
+
+  updateDefinedAlpha();
+  updateDefinedCubic();
+
+  // rebuild caches for changed range (cubic tangents depend on next stops)
+  size_t d = (interpMode() == InterpMode::CUBIC ? 2 : 1);
+
+  double xmin = (k >= d    ? xvalues[k - d] : 0.0);
+  double xmax = (k + d < n ? xvalues[k + d] : 1.0);
+
+  invalidateRange(xmin, xmax);
+
+  //---
+
+  double x1, x2;
+
+  unmapColorRange(xmin, xmax, false, false, x1, x2);
+
+  emit colorsRangeChanged(std::max(x1, 0.0), std::min(x2, 1.0));
+}
+
+void
+CQColorsPalette::
+updateDefinedValues()
+{
+  auto &definedData = definedData_.edit();
+
+  const auto &values = definedData.definedValues;
+
+  auto &xvalues = definedData.definedXValues;
+
+  xvalues.resize(values.size());
+
+  for (size_t i = 0; i < values.size(); ++i)
+    xvalues[i] = mapDefinedColorX(values[i]);
+
+  //---
+
+  auto &floats = definedData.definedFloats;
+
+  auto n = xvalues.size();
+  auto ns = (n > 1 ? n - 1 : 0);
+
+  floats.x.resize(n);
+
+  auto space = interpSpace();
+
+  floats.rgbSegments.resize(8*ns);
+  floats.hsvSegments.resize(8*ns);
+  floats.spaceSegments.resize(space != InterpSpace::MODEL ? 8*ns : 0);
+  floats.alpha        .resize(2*ns);
+
+  for (size_t i = 0; i < n; ++i)
+    floats.x[i] = float(xvalues[i]);
+
+  updateDefinedAlpha();
+
+  for (size_t i = 0; i < ns; ++i)
+    updateDefinedSegment(i);
+
+  updateDefinedCubic();
+}
+
+void
+CQColorsPalette::
+updateDefinedInsert(size_t i, bool rescale)
+{
+  auto &definedData = definedData_.edit();
+
+  auto &xvalues = definedData.definedXValues;
+  auto &floats  = definedData.definedFloats;
+
+  auto n = definedData.definedValues.size();
+  assert(n > 2 && xvalues.size() == n - 1);
+
+  double x = mapDefinedColorX(definedData.definedValues[i]);
+
+  xvalues .insert(xvalues .begin() + std::ptrdiff_t(i), x);
+  floats.x.insert(floats.x.begin() + std::ptrdiff_t(i), float(x));
+
+  // insert record for new segment (inner color splits segment i - 1)
+  auto is = std::min(i, n - 2);
+
+  auto insertRecord = [&](Floats &records, size_t m) {
+    if (! records.empty())
+      records.insert(records.begin() + std::ptrdiff_t(m*is), m, 0.0f);
+  };
+
+  insertRecord(floats.rgbSegments  , 8);
+  insertRecord(floats.hsvSegments  , 8);
+  insertRecord(floats.spaceSegments, 8);
+  insertRecord(floats.alpha        , 2);
+
+  if (rescale)
+    updateDefinedPositions();
+
+  if (i > 0    ) updateDefinedSegment(i - 1);
+  if (i + 1 < n) updateDefinedSegment(i);
+
+  if (definedData.definedColors[i].alpha() < 255)
+    definedData.definedAlpha = true;
+
+  updateDefinedCubic();
+}
+
+void
+CQColorsPalette::
+updateDefinedRemove(size_t i, bool rescale)
+{
+  auto &definedData = definedData_.edit();
+
+  auto &xvalues = definedData.definedXValues;
+  auto &floats  = definedData.definedFloats;
+
+  auto n = definedData.definedValues.size();
+  assert(n > 1 && xvalues.size() == n + 1);
+
+  xvalues .erase(xvalues .begin() + std::ptrdiff_t(i));
+  floats.x.erase(floats.x.begin() + std::ptrdiff_t(i));
+
+  // erase record of removed segment (inner color joins segments i - 1 and i)
+  auto is = std::min(i, n - 1);
+
+  auto eraseRecord = [&](Floats &records, size_t m) {
+    if (! records.empty())
+      records.erase(records.begin() + std::ptrdiff_t(m*is),
+                    records.begin() + std::ptrdiff_t(m*(is + 1)));
+  };
+
+  eraseRecord(floats.rgbSegments  , 8);
+  eraseRecord(floats.hsvSegments  , 8);
+  eraseRecord(floats.spaceSegments, 8);
+  eraseRecord(floats.alpha        , 2);
+
+  if (rescale)
+    updateDefinedPositions();
+
+  if (i > 0 && i < n)
+    updateDefinedSegment(i - 1);
+
+  updateDefinedAlpha();
+  updateDefinedCubic();
+}
+
+void
+CQColorsPalette::
+updateDefinedPositions()
+{
+  auto &definedData = definedData_.edit();
+
+  const auto &values = definedData.definedValues;
+
+  auto &xvalues = definedData.definedXValues;
+  auto &floats  = definedData.definedFloats;
+
+  auto n = values.size();
+
+  for (size_t i = 0; i < n; ++i) {
+    xvalues [i] = mapDefinedColorX(values[i]);
+    floats.x[i] = float(xvalues[i]);
+  }
+
+  // segment start and inverse width (same as updateDefinedSegment)
+  auto setPositions = [&](Floats &segments) {
+    if (segments.empty())
+      return;
+
+    for (size_t i = 0; i + 1 < n; ++i) {
+      double dx = xvalues[i + 1] - xvalues[i];
+
+      auto *s = &segments[8*i];
+
+      s[0] = float(xvalues[i]);
+      s[1] = float(dx > 0.0 ? 1.0/dx : 0.0);
+    }
+  };
+
+  setPositions(floats.rgbSegments  );
+  setPositions(floats.hsvSegments  );
+  setPositions(floats.spaceSegments);
+}
+
+void
+CQColorsPalette::
+updateDefinedAlpha()
+{
+  auto &definedData = definedData_.edit();
+
+  definedData.definedAlpha = false;
+
+  for (const auto &c : definedData.definedColors) {
+    if (c.alpha() < 255)
+      definedData.definedAlpha = true;
+  }
+}
+
+void
+CQColorsPalette::
+updateDefinedSegment(size_t i)
+{
+  auto &definedData = definedData_.edit();
+
+  const auto &xvalues = definedData.definedXValues;
+  const auto &xcolors = definedData.definedColors;
+
+  auto &floats = definedData.definedFloats;
+
+  auto space = interpSpace();
+
+  double dx = xvalues[i + 1] - xvalues[i];
+
+  float x1 = float(xvalues[i]);
+  float dx1 = float(dx > 0.0 ? 1.0/dx : 0.0);
+
+  auto setSegment = [&](Floats &segments, double c11, double c12, double c21, double c22,
+                        double c31, double c32) {
+    auto *s = &segments[8*i];
+
+    s[0] = x1;         s[1] = dx1;
+    s[2] = float(c11); s[3] = float(c12 - c11);
+    s[4] = float(c21); s[5] = float(c22 - c21);
+    s[6] = float(c31); s[7] = float(c32 - c31);
+  };
+
+  qreal r1, g1, b1, a1, r2, g2, b2, a2;
+
+  xcolors[i    ].getRgbF(&r1, &g1, &b1, &a1);
+  xcolors[i + 1].getRgbF(&r2, &g2, &b2, &a2);
+
+  setSegment(floats.rgbSegments, r1, r2, g1, g2, b1, b2);
+
+  floats.alpha[2*i    ] = float(a1);
+  floats.alpha[2*i + 1] = float(a2 - a1);
+
+  double h1, s1, v1, h2, s2, v2;
+
+  colorToHsv(xcolors[i    ], h1, s1, v1);
+  colorToHsv(xcolors[i + 1], h2, s2, v2);
+
+  // fix invalid hue (gray) (see interpHSV)
+  if      (h1 < 0 && h2 < 0) { h1 = 0.0; h2 = 0.0; }
+  else if (h1 < 0)           { h1 = h2; }
+  else if (h2 < 0)           { h2 = h1; }
+
+  setSegment(floats.hsvSegments, h1, h2, s1, s2, v1, v2);
+
+  //---
+
+  // stop values in perceptual space
+  if (space != InterpSpace::MODEL) {
+    double sl1, sa1, sb1, sl2, sa2, sb2;
+
+    if (space == InterpSpace::OKLAB) {
+      CQColorsSpace::rgbToOKLab(r1, g1, b1, sl1, sa1, sb1);
+      CQColorsSpace::rgbToOKLab(r2, g2, b2, sl2, sa2, sb2);
+    }
+    else {
+      CQColorsSpace::rgbToLab(r1, g1, b1, sl1, sa1, sb1);
+      CQColorsSpace::rgbToLab(r2, g2, b2, sl2, sa2, sb2);
+    }
+
+    if (space == InterpSpace::LCH) {
+      double lc1, c1, hc1, lc2, c2, hc2;
+
+      CQColorsSpace::labToLch(sl1, sa1, sb1, lc1, c1, hc1);
+      CQColorsSpace::labToLch(sl2, sa2, sb2, lc2, c2, hc2);
+
+      // fix undefined hue (gray) and use shortest hue path
+      const double minChroma = 1E-4;
+
+      if      (c1 < minChroma && c2 < minChroma) { hc1 = 0.0; hc2 = 0.0; }
+      else if (c1 < minChroma)                   { hc1 = hc2; }
+      else if (c2 < minChroma)                   { hc2 = hc1; }
+
+      if      (hc2 - hc1 >  180.0) hc2 -= 360.0;
+      else if (hc2 - hc1 < -180.0) hc2 += 360.0;
+
+      setSegment(floats.spaceSegments, lc1, lc2, c1, c2, hc1, hc2);
+    }
+    else
+      setSegment(floats.spaceSegments, sl1, sl2, sa1, sa2, sb1, sb2);
+  }
+}
+
+void
+CQColorsPalette::
+updateDefinedCubic()
+{
+  auto &definedData = definedData_.edit();
+
+  const auto &xvalues = definedData.definedXValues;
+
+  auto &floats = definedData.definedFloats;
+
+  // cubic coefficients for segments
+  if (interpMode() == InterpMode::CUBIC) {
+    cubicCoeffs(xvalues, floats.rgbSegments  , floats.rgbCubic  );
+    cubicCoeffs(xvalues, floats.hsvSegments  , floats.hsvCubic  );
+    cubicCoeffs(xvalues, floats.spaceSegments, floats.spaceCubic);
+  }
+  else {
+    floats.rgbCubic  .clear();
+    floats.hsvCubic  .clear();
+    floats.spaceCubic.clear();
+  }
+}
+
+bool
+CQColorsPalette::
+isSegmentInterp(const DefinedData &data)
+{
+  return (data.definedSpace != InterpSpace::MODEL || data.definedMode != InterpMode::LINEAR);
+}
+
+void
+CQColorsPalette::
+definedValues(const DefinedData &data, ColorModel model, size_t i, double m,
+              double &c1, double &c2, double &c3)
+{
+  const auto &floats = data.definedFloats;
+
+  bool space = (data.definedSpace != InterpSpace::MODEL);
+  bool hsv   = (! space && model == ColorModel::HSV);
+
+  if (data.definedMode == InterpMode::CUBIC) {
+    const auto &cubic = (space ? floats.spaceCubic : (hsv ? floats.hsvCubic : floats.rgbCubic));
+
+    const auto *k = &cubic[12*i];
+
+    c1 = k[0] + m*(k[1] + m*(k[ 2] + m*k[ 3]));
+    c2 = k[4] + m*(k[5] + m*(k[ 6] + m*k[ 7]));
+    c3 = k[8] + m*(k[9] + m*(k[10] + m*k[11]));
+  }
+  else {
+    const auto &segments =
+      (space ? floats.spaceSegments : (hsv ? floats.hsvSegments : floats.rgbSegments));
+
+    const auto *s = &segments[8*i];
+
+    c1 = s[2] + m*s[3];
+    c2 = s[4] + m*s[5];
+    c3 = s[6] + m*s[7];
+  }
+}
+
+void
+CQColorsPalette::
+definedRGB(const DefinedData &data, ColorModel model, size_t i, double m,
+           double &r, double &g, double &b)
+{
+  double c1, c2, c3;
+
+  definedValues(data, model, i, m, c1, c2, c3);
+
+  switch (data.definedSpace) {
+    case InterpSpace::OKLAB:
+      CQColorsSpace::okLabToRgb(c1, c2, c3, r, g, b);
+      break;
+    case InterpSpace::LAB:
+      CQColorsSpace::labToRgb(c1, c2, c3, r, g, b);
+      break;
+    case InterpSpace::LCH: {
+      double l, a, bb;
+
+      CQColorsSpace::lchToLab(c1, c2, c3, l, a, bb);
+      CQColorsSpace::labToRgb(l, a, bb, r, g, b);
+
+      break;
+    }
+    default:
+      // linear color models (CMY, YIQ, XYZ) interpolate the same as RGB
+      if (model == ColorModel::HSV)
+        hsvToRgb(c1, c2, c3, r, g, b);
+      else {
+        r = c1; g = c2; b = c3;
+      }
+
+      break;
+  }
+}
+
+double
+CQColorsPalette::
+definedAlpha(const DefinedData &data, size_t i, double m)
+{
+  const auto *a = &data.definedFloats.alpha[2*i];
+
+  return a[0] + m*a[1];
+}
+
+bool
+CQColorsPalette::
+hasAlpha() const
+{
+  return hasAlpha(evalData_);
+}
+
+bool
+CQColorsPalette::
+hasAlpha(const EvalData &eval)
+{
+  return (eval.type == ColorType::DEFINED && (*eval.defined)->definedAlpha);
+}
+
+void
+CQColorsPalette::
+setDefinedColors(const ColorMap &cmap)
+{
+  setColorType(ColorType::DEFINED);
+
+  resetDefinedColors();
+
+  DefinedColors colors;
+
+  colors.reserve(cmap.size());
+
+  for (const auto &c : cmap)
+    colors.push_back(DefinedColor(c.first, c.second));
+
+  addDefinedColors(colors);
+}
+
+void
+CQColorsPalette::
+setDefinedColors(const DefinedColors &colors)
+{
+  setColorType(ColorType::DEFINED);
+
+  resetDefinedColors();
+
+  addDefinedColors(colors);
+}
+
+double
+CQColorsPalette::
+mapDefinedColorX(double x) const
+{
+  double d = definedData_->definedMax - definedData_->definedMin;
+
+  return (d > 0.0 ? (x - definedData_->definedMin)/d : x);
+}
+
+double
+CQColorsPalette::
+unmapDefinedColorX(double x) const
+{
+  double d = definedData_->definedMax - definedData_->definedMin;
+
+  return x*d + definedData_->definedMin;
+}
+
+bool
+CQColorsPalette::
+isDistinct() const
+{
+  return definedData_->definedDistinct;
+}
+
+void
+CQColorsPalette::
+setDistinct(bool b)
+{
+  definedData_.edit().definedDistinct = b;
+
+  invalidate();
+}
+
+bool
+CQColorsPalette::
+isInverted() const
+{
+  return definedData_->definedInverted;
+}
+
+void
+CQColorsPalette::
+setInverted(bool b)
+{
+  definedData_.edit().definedInverted = b;
+
+  invalidate();
+}
+
+CQColorsPalette::InterpSpace
+CQColorsPalette::
+interpSpace() const
+{
+  return definedData_->definedSpace;
+}
+
+void
+CQColorsPalette::
+setInterpSpace(const InterpSpace &space)
+{
+  definedData_.edit().definedSpace = space;
+
+  updateDefinedValues();
+
+  invalidate();
+}
+
+CQColorsPalette::InterpMode
+CQColorsPalette::
+interpMode() const
+{
+  return definedData_->definedMode;
+}
+
+void
+CQColorsPalette::
+setInterpMode(const InterpMode &mode)
+{
+  definedData_.edit().definedMode = mode;
+
+  updateDefinedValues();
+
+  invalidate();
+}
+
+//---
+
+QColor
+CQColorsPalette::
+getColor(int i, int n, WrapMode wrapMode) const
+{
+  assert(i >= 0);
+
+  if      (colorType() == ColorType::DEFINED) {
+    auto nc = definedData_->definedColors.size();
+    if (nc <= 0) return QColor();
+
+    if (isInverted())
+      i = n - 1 - i;
+
+    if      (wrapMode == WrapMode::REPEAT) {
+      while (i < 0)
+        i += nc;
+
+      while (i >= int(nc))
+        i -= nc;
+    }
+    else if (wrapMode == WrapMode::REFLECT) {
+      bool reflect = false;
+
+      while (i < 0) {
+        i += nc;
+
+        reflect = ! reflect;
+      }
+
+      while (i >= int(nc)) {
+        i -= nc;
+
+        reflect = ! reflect;
+      }
+
+      if (reflect)
+        i = int(nc - 1 - size_t(i));
+    }
+    else {
+      if (i < 0 || i >= int(nc))
+        return QColor();
+    }
+
+    return definedColorData(i).c;
+  }
+  else {
+    if (n < 0)
+      n = defaultNumColors(); // TODO: default value
+
+    if (n <= 0)
+      return QColor();
+
+    double r = (n > 1 ? 1.0*i/(n - 1) : 0.0);
+
+    return getColor(r);
+  }
+}
+
+QColor
+CQColorsPalette::
+getColor(double x, bool scale, bool invert) const
+{
+  const auto &eval = evalData();
+
+  return eval.proc(eval, mapColorX(eval, x, scale, invert));
+}
+
+QColor
+CQColorsPalette::Sampler::
+getColor(double x)
+{
+  x = palette_->mapColorX(x, scale_, invert_);
+
+  if (palette_->isLut())
+    return palette_->lutColor(x);
+
+  if (palette_->colorType() != ColorType::DEFINED || ! palette_->numDefinedColors())
+    return palette_->gammaColor(palette_->gammaData_, palette_->interpColor(x));
+
+  size_t i1, i2;
+  double m;
+
+  palette_->definedSegment(x, i1, i2, m, segment_);
+
+  auto c = interpDefinedColor(*palette_->definedData_, palette_->colorModel(), i1, i2, m);
+
+  return palette_->gammaColor(palette_->gammaData_, c);
+}
+
+double
+CQColorsPalette::
+mapColorX(double x, bool scale, bool invert) const
+{
+  return mapColorX(evalData_, x, scale, invert);
+}
+
+double
+CQColorsPalette::
+mapColorX(const EvalData &eval, double x, bool scale, bool invert)
+{
+  // scale and invert only apply to (non-empty) defined colors
+  if (eval.type != ColorType::DEFINED)
+    return x;
+
+  const auto &defined = **eval.defined;
+
+  if (defined.definedColors.empty())
+    return x;
+
+  if (scale) {
+    double d = defined.definedMax - defined.definedMin;
+
+    if (d > 0.0)
+      x = (x - defined.definedMin)/d;
+  }
+
+  if (invert)
+    x = 1.0 - x;
+
+  if (defined.definedInverted)
+    x = 1.0 - x;
+
+  return x;
+}
+
+QColor
+CQColorsPalette::
+interpColor(double x) const
+{
+  if      (colorType() == ColorType::DEFINED) {
+    if (definedData_->definedColors.empty()) {
+      QColor c1(Qt::black);
+      QColor c2(Qt::white);
+
+      if      (colorModel() == ColorModel::RGB)
+        return interpRGB(c1, c2, x);
+      else if (colorModel() == ColorModel::HSV)
+        return interpHSV(c1, c2, x);
+      else
+        return interpRGB(c1, c2, x);
+    }
+
+    size_t i1, i2;
+    double m;
+
+    definedSegment(definedData_->definedXValues, x, i1, i2, m);
+
+    return interpDefinedColor(*definedData_, colorModel(), i1, i2, m);
+  }
+  else if (colorType() == ColorType::MODEL) {
+    if (isGray()) {
+      double g = CMathUtil::clamp(x, 0.0, 1.0);
+
+      if (isRedNegative() || isGreenNegative() || isBlueNegative())
+        g = 1.0 - g;
+
+      // same rounding as batch colors (see getColors)
+      int gi = toByte(g);
+
+      return QColor(gi, gi, gi);
+    }
+
+    //---
+
+    double r, g, b;
+
+    modelRGB(evalData_.channels, x, r, g, b);
+
+    return modelToColor(colorModel(), r, g, b);
+  }
+  else if (colorType() == ColorType::FUNCTIONS) {
+    double r = 0.0, g = 0.0, b = 0.0;
+
+#ifdef CQCOLORS_TCL
+    auto *qtcl = this->qtcl();
+
+    qtcl->createVar("gray", x);
+
+    QVariant res;
+    bool     ok;
+
+    if (qtcl->evalExpr(tclFnData_.rf.fn.c_str(), res))
+      r = CQTclUtil::toReal(res, ok);
+
+    if (qtcl->evalExpr(tclFnData_.gf.fn.c_str(), res))
+      g = CQTclUtil::toReal(res, ok);
+
+    if (qtcl->evalExpr(tclFnData_.bf.fn.c_str(), res))
+      b = CQTclUtil::toReal(res, ok);
+#endif
+
+    //---
+
+    r = CMathUtil::clamp(r, 0.0, 1.0);
+    g = CMathUtil::clamp(g, 0.0, 1.0);
+    b = CMathUtil::clamp(b, 0.0, 1.0);
+
+    return modelToColor(colorModel(), r, g, b);
+  }
+  else if (colorType() == ColorType::CUBEHELIX) {
+    // clamped and rounded as batch colors (see getColors)
+    double r, g, b;
+
+    cubeHelix()->interpRGB(x, r, g, b, isCubeNegative());
+
+    return QColor(toByte(r), toByte(g), toByte(b));
+  }
+  else {
+    return QColor(0, 0, 0);
+  }
+}
+
+void
+CQColorsPalette::
+definedSegment(const Reals &xvalues, double x, size_t &i1, size_t &i2, double &m)
+{
+  m = 0.0;
+
+  if (x <= xvalues.front()) {
+    i1 = 0; i2 = 0; return;
+  }
+
+  // also handles NaN
+  if (! (x <= xvalues.back())) {
+    i1 = xvalues.size() - 1; i2 = i1; return;
+  }
+
+  // find first value >= x (index in range 1->n-1)
+  i2 = size_t(std::lower_bound(xvalues.begin(), xvalues.end(), x) - xvalues.begin());
+  i1 = i2 - 1;
+
+  m = (x - xvalues[i1])/(xvalues[i2] - xvalues[i1]);
+}
+
+void
+CQColorsPalette::
+definedSegment(double x, size_t &i1, size_t &i2, double &m, size_t &hint) const
+{
+  const auto &xvalues = definedData_->definedXValues;
+
+  m = 0.0;
+
+  if (x <= xvalues.front()) {
+    i1 = 0; i2 = 0; return;
+  }
+
+  // also handles NaN
+  if (! (x <= xvalues.back())) {
+    i1 = xvalues.size() - 1; i2 = i1; return;
+  }
+
+  // find first value >= x (index in range 1->n-1) starting from hint segment
+  auto n = xvalues.size();
+
+  i2 = std::min(std::max(hint, size_t(1)), n - 1);
+
+  if      (x > xvalues[i2]) {
+    // step to next segment, search rest if not there
+    ++i2;
+
+    if (x > xvalues[i2])
+      i2 = size_t(std::lower_bound(xvalues.begin() + i2, xvalues.end(), x) - xvalues.begin());
+  }
+  else if (x <= xvalues[i2 - 1]) {
+    // step to previous segment, search start if not there
+    --i2;
+
+    if (x <= xvalues[i2 - 1])
+      i2 = size_t(std::lower_bound(xvalues.begin(), xvalues.begin() + i2, x) - xvalues.begin());
+  }
+
+  i1   = i2 - 1;
+  hint = i2;
+
+  m = (x - xvalues[i1])/(xvalues[i2] - xvalues[i1]);
+}
+
+QColor
+CQColorsPalette::
+interpDefinedColor(const DefinedData &data, ColorModel model, size_t i1, size_t i2, double m)
+{
+  const auto &xcolors = data.definedColors;
+
+  const auto &c1 = xcolors[i1];
+  const auto &c2 = xcolors[i2];
+
+  if (i1 == i2) return c1;
+
+  if (isSegmentInterp(data)) {
+    double r, g, b;
+
+    definedRGB(data, model, i1, m, r, g, b);
+
+    return QColor::fromRgbF(CMathUtil::clamp(r, 0.0, 1.0), CMathUtil::clamp(g, 0.0, 1.0),
+                            CMathUtil::clamp(b, 0.0, 1.0), definedAlpha(data, i1, m));
+  }
+
+  // linear color models (CMY, YIQ, XYZ) interpolate the same as RGB
+  if (model == ColorModel::HSV)
+    return interpHSV(c1, c2, m);
+  else
+    return interpRGB(c1, c2, m);
+}
+
+void
+CQColorsPalette::
+modelRGB(const ModelChannel *channels, double x, double &r, double &g, double &b)
+{
+  double x1 = CMathUtil::clamp(x, 0.0, 1.0);
+
+  // channel value with negate and min/max map (see updateEvaluator)
+  auto channelValue = [&](const ModelChannel &channel) {
+    return channel.offset + channel.scale*CMathUtil::clamp(tableModel(channel.model, x1), 0.0, 1.0);
+  };
+
+  r = channelValue(channels[0]);
+  g = channelValue(channels[1]);
+  b = channelValue(channels[2]);
+}
+
+//---
+
+void
+CQColorsPalette::
+getColors(const double *x, int n, QRgb *rgb, bool scale, bool invert, bool premultiplied) const
+{
+  getColorsRgbT(evalData(), x, n, rgb, scale, invert, premultiplied);
+}
+
+void
+CQColorsPalette::
+getColors(const float *x, int n, QRgb *rgb, bool scale, bool invert, bool premultiplied) const
+{
+  getColorsRgbT(evalData(), x, n, rgb, scale, invert, premultiplied);
+}
+
+CQColorsPalette::ColorF
+CQColorsPalette::
+getColorF(double x, bool scale, bool invert) const
+{
+  ColorF c;
+
+  getColorsT(evalData(), &x, 1, &c, scale, invert);
+
+  return c;
+}
+
+void
+CQColorsPalette::
+getColorsF(const double *x, int n, ColorF *c, bool scale, bool invert) const
+{
+  getColorsT(evalData(), x, n, c, scale, invert);
+}
+
+void
+CQColorsPalette::
+getColorsF(const float *x, int n, ColorF *c, bool scale, bool invert) const
+{
+  getColorsT(evalData(), x, n, c, scale, invert);
+}
+
+QRgba64
+CQColorsPalette::
+getColor64(double x, bool scale, bool invert) const
+{
+  QRgba64 c;
+
+  getColorsT(evalData(), &x, 1, &c, scale, invert);
+
+  return c;
+}
+
+void
+CQColorsPalette::
+getColors64(const double *x, int n, QRgba64 *c, bool scale, bool invert) const
+{
+  getColorsT(evalData(), x, n, c, scale, invert);
+}
+
+void
+CQColorsPalette::
+getColors64(const float *x, int n, QRgba64 *c, bool scale, bool invert) const
+{
+  getColorsT(evalData(), x, n, c, scale, invert);
+}
+
+void
+CQColorsPalette::
+getColors(const uint8_t *v, int n, QRgb *rgb, bool scale, bool invert, bool premultiplied) const
+{
+  const auto *table = intTable(evalData(), intTables_, 8, scale, invert, premultiplied);
+
+  for (int i = 0; i < n; ++i)
+    rgb[i] = table[v[i]];
+}
+
+void
+CQColorsPalette::
+getColors(const uint16_t *v, int n, QRgb *rgb, bool scale, bool invert,
+          bool premultiplied) const
+{
+  const auto *table = intTable(evalData(), intTables_, 16, scale, invert, premultiplied);
+
+  for (int i = 0; i < n; ++i)
+    rgb[i] = table[v[i]];
+}
+
+QImage
+CQColorsPalette::
+colorizeImage(const QImage &image, bool scale, bool invert, bool premultiplied) const
+{
+  return colorizeImage(evalData(), intTables_, image, scale, invert, premultiplied);
+}
+
+QImage
+CQColorsPalette::
+colorizeImage(const EvalData &eval, IntTables &tables, const QImage &image, bool scale,
+              bool invert, bool premultiplied)
+{
+  if (image.isNull())
+    return QImage();
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+  bool is16 = (image.format() == QImage::Format_Grayscale16);
+#else
+  bool is16 = false;
+#endif
+
+  if (! is16 && image.format() != QImage::Format_Grayscale8)
+    return colorizeImage(eval, tables, image.convertToFormat(QImage::Format_Grayscale8),
+                         scale, invert, premultiplied);
+
+  const auto *table = intTable(eval, tables, is16 ? 16 : 8, scale, invert, premultiplied);
+
+  int w = image.width ();
+  int h = image.height();
+
+  QImage image1(w, h, premultiplied ? QImage::Format_ARGB32_Premultiplied :
+                                      QImage::Format_ARGB32);
+
+  for (int y = 0; y < h; ++y) {
+    auto *rgb = reinterpret_cast<QRgb *>(image1.scanLine(y));
+
+    if (is16) {
+      const auto *v = reinterpret_cast<const uint16_t *>(image.constScanLine(y));
+
+      for (int x = 0; x < w; ++x)
+        rgb[x] = table[v[x]];
+    }
+    else {
+      const auto *v = reinterpret_cast<const uint8_t *>(image.constScanLine(y));
+
+      for (int x = 0; x < w; ++x)
+        rgb[x] = table[v[x]];
+    }
+  }
+
+  return image1;
+}
+
+const QRgb *
+CQColorsPalette::
+intTable(const EvalData &eval, IntTables &tables, int bits, bool scale, bool invert,
+         bool premultiplied)
+{
+  auto ind = intTableIndex(scale, invert, premultiplied);
+
+  auto &table = (bits == 16 ? tables.tables16 : tables.tables8)[ind];
+
+  if (! table.valid) {
+    std::lock_guard<std::mutex> lock(tables.mutex);
+
+    // built by other thread while waiting
+    if (! table.valid) {
+      int n = (1 << bits);
+
+      Reals x(n);
+
+      for (int i = 0; i < n; ++i)
+        x[i] = i/(n - 1.0);
+
+      table.colors.resize(n);
+
+      getColorsRgbT(eval, x.data(), n, table.colors.data(), scale, invert, premultiplied);
+
+      table.valid = true;
+    }
+  }
+
+  return table.colors.data();
+}
+
+template<typename T>
+void
+CQColorsPalette::
+getColorsRgbT(const EvalData &eval, const T *x, int n, QRgb *rgb, bool scale, bool invert,
+              bool premultiplied)
+{
+  // premultiply is a no-op for opaque colors
+  if (! premultiplied || ! hasAlpha(eval)) {
+    getColorsT(eval, x, n, rgb, scale, invert);
+    return;
+  }
+
+  // premultiply chunks while still in cache
+  const int chunkSize = 256;
+
+  for (int i = 0; i < n; i += chunkSize) {
+    int nc = std::min(n - i, chunkSize);
+
+    getColorsT(eval, x + i, nc, rgb + i, scale, invert);
+
+    for (int j = 0; j < nc; ++j)
+      rgb[i + j] = qPremultiply(rgb[i + j]);
+  }
+}
+
+template<typename T, typename C>
+void
+CQColorsPalette::
+getColorsT(const EvalData &eval, const T *x, int n, C *c, bool scale, bool invert)
+{
+  // lookup table (built by caller)
+  if (eval.lut) {
+    for (int i = 0; i < n; ++i) {
+      auto lc = lutColorF(eval.lut->colors, eval.lut->interp,
+                          mapColorX(eval, double(x[i]), scale, invert));
+
+      storeColor(c[i], lc.r, lc.g, lc.b, lc.a);
+    }
+
+    return;
+  }
+
+  //---
+
+  // gamma correction (from table) applied to channel values as they are stored
+  const auto &gammaData = *eval.gamma;
+
+  bool gamma = ! gammaData.values.empty();
+
+  auto storeRGB = [&](C &ci, double r, double g, double b, double a) {
+    if (gamma) {
+      r = gammaValue(gammaData, r);
+      g = gammaValue(gammaData, g);
+      b = gammaValue(gammaData, b);
+    }
+
+    storeColor(ci, r, g, b, a);
+  };
+
+  auto storeQColor = [&](C &ci, const QColor &qc) {
+    storeColor(ci, gamma ? gammaColor(gammaData, qc) : qc);
+  };
+
+  //---
+
+  if      (eval.type == ColorType::DEFINED && ! (*eval.defined)->definedColors.empty()) {
+    const auto &defined = **eval.defined;
+
+    const auto &xcolors = defined.definedColors;
+
+    bool hsv = (eval.model == ColorModel::HSV);
+
+    // vector kernels (if supported) for packed opaque rgb (without gamma correction)
+    const auto &floats = defined.definedFloats;
+
+    bool segmentInterp = isSegmentInterp(defined);
+
+    if (std::is_same<C, QRgb>::value && ! segmentInterp && ! defined.definedAlpha && ! gamma &&
+        floats.x.size() > 1 && CQColorsSIMD::level() != CQColorsSIMD::Level::NONE) {
+      auto *rgb = reinterpret_cast<QRgb *>(c);
+
+      CQColorsSIMD::Stops stops;
+      stops.x        = floats.x.data();
+      stops.segments = (hsv ? floats.hsvSegments : floats.rgbSegments).data();
+      stops.n        = int(floats.x.size());
+
+      // map x in chunks (see mapColorX)
+      const int chunkSize = 256;
+
+      float xc[chunkSize];
+
+      double xmin = defined.definedMin;
+      double xd   = defined.definedMax - xmin;
+
+      if (! scale || xd <= 0.0) { xmin = 0.0; xd = 1.0; }
+
+      bool flip = (invert != defined.definedInverted);
+
+      bool done = true;
+
+      for (int i = 0; i < n && done; i += chunkSize) {
+        int nc = std::min(chunkSize, n - i);
+
+        if (flip) {
+          for (int j = 0; j < nc; ++j)
+            xc[j] = float(1.0 - (double(x[i + j]) - xmin)/xd);
+        }
+        else {
+          for (int j = 0; j < nc; ++j)
+            xc[j] = float((double(x[i + j]) - xmin)/xd);
+        }
+
+        if (hsv)
+          done = CQColorsSIMD::interpHSV(stops, xc, nc, rgb + i);
+        else
+          done = CQColorsSIMD::interpRGB(stops, xc, nc, rgb + i);
+      }
+
+      // use scalar loop if kernel not run
+      if (done)
+        return;
+    }
+
+    for (int i = 0; i < n; ++i) {
+      size_t i1, i2;
+      double m;
+
+      definedSegment(defined.definedXValues, mapColorX(eval, double(x[i]), scale, invert),
+                     i1, i2, m);
+
+      const auto &c1 = xcolors[i1];
+      const auto &c2 = xcolors[i2];
+
+      if      (i1 == i2)
+        storeQColor(c[i], c1);
+      else if (segmentInterp) {
+        double r, g, b;
+
+        definedRGB(defined, eval.model, i1, m, r, g, b);
+
+        storeRGB(c[i], r, g, b, definedAlpha(defined, i1, m));
+      }
+      else if (hsv)
+        storeQColor(c[i], interpHSV(c1, c2, m));
+      else {
+        qreal r1, g1, b1, a1;
+        qreal r2, g2, b2, a2;
+
+        c1.getRgbF(&r1, &g1, &b1, &a1);
+        c2.getRgbF(&r2, &g2, &b2, &a2);
+
+        storeRGB(c[i], interpValue(r1, r2, m), interpValue(g1, g2, m), interpValue(b1, b2, m),
+                 interpValue(a1, a2, m));
+      }
+    }
+  }
+  else if (eval.type == ColorType::MODEL) {
+    if (eval.gray) {
+      bool negate = eval.grayNegate;
+
+      for (int i = 0; i < n; ++i) {
+        double g = CMathUtil::clamp(double(x[i]), 0.0, 1.0);
+
+        if (negate)
+          g = 1.0 - g;
+
+        storeRGB(c[i], g, g, g, 1.0);
+      }
+    }
+    else {
+      auto model = eval.model;
+
+      bool hsv = (model == ColorModel::HSV);
+
+      const auto *matrix = linearModelMatrix(model);
+
+      if (hsv || matrix) {
+        // convert chunks of model values to rgb
+        const int chunkSize = 256;
+
+        float c1[chunkSize], c2[chunkSize], c3[chunkSize];
+        float r [chunkSize], g [chunkSize], b [chunkSize];
+
+        for (int i = 0; i < n; i += chunkSize) {
+          int nc = std::min(n - i, chunkSize);
+
+          for (int j = 0; j < nc; ++j) {
+            double v1, v2, v3;
+
+            modelRGB(eval.channels, double(x[i + j]), v1, v2, v3);
+
+            c1[j] = float(v1); c2[j] = float(v2); c3[j] = float(v3);
+          }
+
+          modelsToRgb(model, c1, c2, c3, nc, r, g, b);
+
+          for (int j = 0; j < nc; ++j)
+            storeRGB(c[i + j], r[j], g[j], b[j], 1.0);
+        }
+      }
+      else {
+        for (int i = 0; i < n; ++i) {
+          double r, g, b;
+
+          modelRGB(eval.channels, double(x[i]), r, g, b);
+
+          storeRGB(c[i], r, g, b, 1.0);
+        }
+      }
+    }
+  }
+  else if (eval.type == ColorType::CUBEHELIX) {
+    const auto *cubeHelix = eval.cubeHelix;
+
+    bool negate = eval.cubeNegative;
+
+    // interpolate chunks of values from cube helix table
+    const int chunkSize = 256;
+
+    float rgbs[3*chunkSize];
+
+    for (int i = 0; i < n; i += chunkSize) {
+      int nc = std::min(n - i, chunkSize);
+
+      cubeHelix->interpRGB(x + i, nc, rgbs, negate);
+
+      for (int j = 0; j < nc; ++j)
+        storeRGB(c[i + j], rgbs[3*j], rgbs[3*j + 1], rgbs[3*j + 2], 1.0);
+    }
+  }
+  else {
+    for (int i = 0; i < n; ++i)
+      storeQColor(c[i], eval.baseProc(eval, mapColorX(eval, double(x[i]), scale, invert)));
+  }
+}
+
+// batch colors used by snapshot
+template void CQColorsPalette::getColorsT<double, CQColorsPalette::ColorF>(
+  const EvalData &, const double *, int, ColorF *, bool, bool);
+template void CQColorsPalette::getColorsT<float, CQColorsPalette::ColorF>(
+  const EvalData &, const float *, int, ColorF *, bool, bool);
+template void CQColorsPalette::getColorsRgbT<double>(
+  const EvalData &, const double *, int, QRgb *, bool, bool, bool);
+template void CQColorsPalette::getColorsRgbT<float>(
+  const EvalData &, const float *, int, QRgb *, bool, bool, bool);
+
+
+//---
+
+void
+CQColorsPalette::
+setLutSize(int n)
+{
+  lutData_.size = std::max(n, 0);
+
+  invalidate();
+}
+
+void
+CQColorsPalette::
+setLutMaxError(double e)
+{
+  lutData_.maxError = std::max(e, 0.0);
+
+  invalidate();
+}
+
+int
+CQColorsPalette::
+lutColorsSize() const
+{
+  if (! isLut())
+    return 0;
+
+  if (! lutData_.valid)
+    updateLut();
+
+  return int(lutData_.colors.size());
+}
+
+double
+CQColorsPalette::
+lutError() const
+{
+  if (! isLut())
+    return 0.0;
+
+  if (! lutData_.valid)
+    updateLut();
+
+  std::lock_guard<std::recursive_mutex> lock(cacheMutex_);
+
+  if (lutData_.error < 0.0) {
+    Reals labs;
+
+    lutTestColors(labs);
+
+    lutData_.error = lutTestError(labs);
+  }
+
+  return lutData_.error;
+}
+
+void
+CQColorsPalette::
+setLutInterp(bool b)
+{
+  lutData_.interp = b;
+
+  // automatic size depends on interp
+  if (lutMaxError() > 0.0)
+    lutData_.valid = false;
+
+  lutData_.error = -1.0;
+
+  integralData_.valid = false;
+  mipData_     .valid = false;
+
+  invalidateIntTables();
+
+  gradientImageDirty_ = true;
+
+  emit colorsChanged();
+}
+
+QColor
+CQColorsPalette::
+lutColor(double x) const
+{
+  if (! lutData_.valid)
+    updateLut();
+
+  auto c = lutColorF(lutData_.colors, isLutInterp(), x);
+
+  return QColor::fromRgbF(c.r, c.g, c.b, c.a);
+}
+
+CQColorsPalette::ColorF
+CQColorsPalette::
+lutColorF(const ColorFs &colors, bool interp, double x)
+{
+  auto n = int(colors.size());
+
+  // table covers 0.0->1.0, values outside are clamped
+  double t = CMathUtil::clamp(x, 0.0, 1.0)*(n - 1);
+
+  if (! interp)
+    return colors[size_t(std::lround(t))];
+
+  int i1 = std::min(int(t), n - 2);
+
+  float f = float(t - i1);
+
+  const auto &c1 = colors[size_t(i1    )];
+  const auto &c2 = colors[size_t(i1 + 1)];
+
+  ColorF c;
+
+  c.r = c1.r + (c2.r - c1.r)*f;
+  c.g = c1.g + (c2.g - c1.g)*f;
+  c.b = c1.b + (c2.b - c1.b)*f;
+  c.a = c1.a + (c2.a - c1.a)*f;
+
+  return c;
+}
+
+void
+CQColorsPalette::
+updateLut() const
+{
+  std::lock_guard<std::recursive_mutex> lock(cacheMutex_);
+
+  // built by other thread while waiting
+  if (lutData_.valid)
+    return;
+
+  lutData_.error = -1.0;
+
+  if (lutMaxError() <= 0.0) {
+    // at least two entries (for interp)
+    bakeLut(std::max(lutSize(), 2));
+
+    lutData_.valid = true;
+
+    return;
+  }
+
+  //---
+
+  // smallest size with error less than max error (up to max size)
+  auto maxError = lutMaxError();
+
+  Reals labs;
+
+  lutTestColors(labs);
+
+  auto sizeError = [&](int n) {
+    bakeLut(n);
+
+    return lutTestError(labs);
+  };
+
+  // double cells until error met (power of two cells so entries hit dyadic stops)
+  int n1 = 1;
+  int n2 = 2;
+
+  double e2 = sizeError(n2);
+
+  while (e2 > maxError && n2 < maxLutSize) {
+    n1 = n2;
+    n2 = std::min(2*n2 - 1, maxLutSize);
+    e2 = sizeError(n2);
+  }
+
+  // bisect between failed and met sizes
+  if (e2 <= maxError) {
+    while (n2 - n1 > 1) {
+      int n = (n1 + n2)/2;
+
+      double e = sizeError(n);
+
+      if (e <= maxError) {
+        n2 = n;
+        e2 = e;
+      }
+      else
+        n1 = n;
+    }
+  }
+
+  if (int(lutData_.colors.size()) != n2)
+    bakeLut(n2);
+
+  lutData_.error = e2;
+  lutData_.valid = true;
+}
+
+void
+CQColorsPalette::
+lutTestColors(Reals &labs) const
+{
+  labs.resize(3*(lutTestSteps + 1));
+
+  for (int i = 0; i <= lutTestSteps; ++i) {
+    auto c = gammaColor(gammaData_, interpColor(double(i)/lutTestSteps));
+
+    auto *lab = &labs[3*size_t(i)];
+
+    CQColorsSpace::rgbToLab(c.redF(), c.greenF(), c.blueF(), lab[0], lab[1], lab[2]);
+  }
+}
+
+double
+CQColorsPalette::
+lutTestError(const Reals &labs) const
+{
+  double maxError = 0.0;
+
+  for (int i = 0; i <= lutTestSteps; ++i) {
+    auto c = lutColorF(lutData_.colors, isLutInterp(), double(i)/lutTestSteps);
+
+    double l, a, b;
+
+    CQColorsSpace::rgbToLab(c.r, c.g, c.b, l, a, b);
+
+    const auto *lab = &labs[3*size_t(i)];
+
+    maxError = std::max(maxError, std::hypot(l - lab[0], a - lab[1], b - lab[2]));
+  }
+
+  return maxError;
+}
+
+void
+CQColorsPalette::
+bakeLut(int n) const
+{
+  lutData_.colors.resize(size_t(n));
+
+  bakeLutRange(0, n - 1);
+}
+
+void
+CQColorsPalette::
+bakeLutRange(int i1, int i2) const
+{
+  auto &colors = lutData_.colors;
+
+  auto n = int(colors.size());
+
+  i1 = std::max(i1, 0);
+  i2 = std::min(i2, n - 1);
+
+  // table colors are gamma corrected
+  for (int i = i1; i <= i2; ++i) {
+    auto c = gammaColor(gammaData_, interpColor(1.0*i/(n - 1)));
+
+    qreal r, g, b, a;
+
+    c.getRgbF(&r, &g, &b, &a);
+
+    auto &lc = colors[size_t(i)];
+
+    lc.r = float(r);
+    lc.g = float(g);
+    lc.b = float(b);
+    lc.a = float(a);
+  }
+}
+
+CQColorsPalette::ColorF
+CQColorsPalette::
+getMeanColorF(double x0, double x1, bool scale, bool invert) const
+{
+  double m0 = mapColorX(x0, scale, invert);
+  double m1 = mapColorX(x1, scale, invert);
+
+  // empty range is point sample
+  if (std::abs(m1 - m0) < 1E-12)
+    return getColorF(x0, scale, invert);
+
+  if (! integralData_.valid)
+    updateIntegrals();
+
+  double s0[4], s1[4];
+
+  integralColor(m0, s0);
+  integralColor(m1, s1);
+
+  // mean is integral over range divided by range width (sign cancels if inverted)
+  double d = m1 - m0;
+
+  ColorF c;
+
+  c.r = float(CMathUtil::clamp((s1[0] - s0[0])/d, 0.0, 1.0));
+  c.g = float(CMathUtil::clamp((s1[1] - s0[1])/d, 0.0, 1.0));
+  c.b = float(CMathUtil::clamp((s1[2] - s0[2])/d, 0.0, 1.0));
+  c.a = float(CMathUtil::clamp((s1[3] - s0[3])/d, 0.0, 1.0));
+
+  return c;
+}
+
+QColor
+CQColorsPalette::
+getMeanColor(double x0, double x1, bool scale, bool invert) const
+{
+  auto c = getMeanColorF(x0, x1, scale, invert);
+
+  return QColor::fromRgbF(c.r, c.g, c.b, c.a);
+}
+
+void
+CQColorsPalette::
+integralColor(double x, double *s) const
+{
+  const auto &colors = integralData_.colors;
+  const auto &sums   = integralData_.sums;
+
+  // colors are clamped outside 0.0->1.0 so integral is linear there
+  if (! (x > 0.0)) {
+    const auto &c = colors[0];
+
+    s[0] = c.r*x; s[1] = c.g*x; s[2] = c.b*x; s[3] = c.a*x;
+
+    return;
+  }
+
+  if (x >= 1.0) {
+    const auto &c = colors[integralSteps];
+    const auto *s1 = &sums[4*integralSteps];
+
+    double d = x - 1.0;
+
+    s[0] = s1[0] + c.r*d; s[1] = s1[1] + c.g*d; s[2] = s1[2] + c.b*d; s[3] = s1[3] + c.a*d;
+
+    return;
+  }
+
+  // cumulative sum to step start plus integral of linear color to x
+  double t = x*integralSteps;
+
+  int i = std::min(int(t), integralSteps - 1);
+
+  double u  = t - i;
+  double h  = 1.0/integralSteps;
+  double hu = h*u;
+  double f  = 0.5*hu*u;
+
+  const auto &c1 = colors[size_t(i    )];
+  const auto &c2 = colors[size_t(i + 1)];
+
+  const auto *s1 = &sums[4*size_t(i)];
+
+  s[0] = s1[0] + c1.r*hu + (c2.r - c1.r)*f;
+  s[1] = s1[1] + c1.g*hu + (c2.g - c1.g)*f;
+  s[2] = s1[2] + c1.b*hu + (c2.b - c1.b)*f;
+  s[3] = s1[3] + c1.a*hu + (c2.a - c1.a)*f;
+}
+
+void
+CQColorsPalette::
+updateIntegrals() const
+{
+  std::lock_guard<std::recursive_mutex> lock(cacheMutex_);
+
+  // built by other thread while waiting
+  if (integralData_.valid)
+    return;
+
+  integralData_.colors.resize(integralSteps + 1);
+  integralData_.sums  .resize(4*(integralSteps + 1));
+
+  updateIntegrals(0, integralSteps);
+}
+
+void
+CQColorsPalette::
+updateIntegrals(int i1, int i2) const
+{
+  auto &colors = integralData_.colors;
+  auto &sums   = integralData_.sums;
+
+  i1 = std::max(i1, 0);
+  i2 = std::min(i2, integralSteps);
+
+  const auto &eval = evalData();
+
+  // sample evaluated (mapped) colors in range
+  for (int i = i1; i <= i2; ++i) {
+    auto c = eval.proc(eval, double(i)/integralSteps);
+
+    qreal r, g, b, a;
+
+    c.getRgbF(&r, &g, &b, &a);
+
+    auto &ic = colors[size_t(i)];
+
+    ic.r = float(r); ic.g = float(g); ic.b = float(b); ic.a = float(a);
+  }
+
+  // trapezoid rule cumulative sums (from first changed sample)
+  double h = 0.5/integralSteps;
+
+  for (int k = 0; k < 4; ++k)
+    sums[size_t(k)] = 0.0;
+
+  for (int i = i1; i < integralSteps; ++i) {
+    const auto &c1 = colors[size_t(i    )];
+    const auto &c2 = colors[size_t(i + 1)];
+
+    const auto *s1 = &sums[4*size_t(i)];
+    auto       *s2 = &sums[4*size_t(i + 1)];
+
+    s2[0] = s1[0] + h*(c1.r + c2.r);
+    s2[1] = s1[1] + h*(c1.g + c2.g);
+    s2[2] = s1[2] + h*(c1.b + c2.b);
+    s2[3] = s1[3] + h*(c1.a + c2.a);
+  }
+
+  integralData_.valid = true;
+}
+
+CQColorsPalette::ColorF
+CQColorsPalette::
+getMipColorF(double x, double footprint, bool scale, bool invert) const
+{
+  double m = mapColorX(x, scale, invert);
+
+  // footprint in mapped range
+  int level = mipLevel(std::abs(mapColorX(x + footprint, scale, invert) - m));
+
+  if (level < 0)
+    return getColorF(x, scale, invert);
+
+  if (! mipData_.valid)
+    updateMipLevels();
+
+  const auto &colors = mipData_.levels[size_t(level)];
+
+  auto nc = int(colors.size());
+
+  // interpolate between cell centers (clamped to end cells)
+  double t = CMathUtil::clamp(m, 0.0, 1.0)*nc - 0.5;
+
+  if (t <= 0.0     ) return colors[0];
+  if (t >= nc - 1.0) return colors[size_t(nc - 1)];
+
+  int i = int(t);
+
+  float f = float(t - i);
+
+  const auto &c1 = colors[size_t(i    )];
+  const auto &c2 = colors[size_t(i + 1)];
+
+  ColorF c;
+
+  c.r = c1.r + (c2.r - c1.r)*f;
+  c.g = c1.g + (c2.g - c1.g)*f;
+  c.b = c1.b + (c2.b - c1.b)*f;
+  c.a = c1.a + (c2.a - c1.a)*f;
+
+  return c;
+}
+
+QColor
+CQColorsPalette::
+getMipColor(double x, double footprint, bool scale, bool invert) const
+{
+  auto c = getMipColorF(x, footprint, scale, invert);
+
+  return QColor::fromRgbF(c.r, c.g, c.b, c.a);
+}
+
+int
+CQColorsPalette::
+numMipLevels() const
+{
+  int n = 0;
+
+  for (int size = mipSize; size > 0; size >>= 1)
+    ++n;
+
+  return n;
+}
+
+int
+CQColorsPalette::
+mipLevel(double footprint) const
+{
+  // footprint in finest level cells
+  double cells = footprint*mipSize;
+
+  if (! (cells > 0.5))
+    return -1;
+
+  // first level with cell width covering footprint
+  int level = std::max(int(std::ceil(std::log2(cells))), 0);
+
+  return std::min(level, numMipLevels() - 1);
+}
+
+void
+CQColorsPalette::
+updateMipLevels() const
+{
+  std::lock_guard<std::recursive_mutex> lock(cacheMutex_);
+
+  // built by other thread while waiting
+  if (mipData_.valid)
+    return;
+
+  auto &levels = mipData_.levels;
+
+  levels.resize(size_t(numMipLevels()));
+
+  for (size_t l = 0; l < levels.size(); ++l)
+    levels[l].resize(size_t(mipSize >> l));
+
+  updateMipLevels(0, mipSize - 1);
+}
+
+void
+CQColorsPalette::
+updateMipLevels(int i1, int i2) const
+{
+  if (! integralData_.valid)
+    updateIntegrals();
+
+  auto &levels = mipData_.levels;
+
+  i1 = std::max(i1, 0);
+  i2 = std::min(i2, mipSize - 1);
+
+  // finest level is mean color of each cell (from integrals)
+  auto &colors = levels[0];
+
+  double s1[4], s2[4];
+
+  integralColor(double(i1)/mipSize, s1);
+
+  for (int i = i1; i <= i2; ++i) {
+    integralColor(double(i + 1)/mipSize, s2);
+
+    auto &c = colors[size_t(i)];
+
+    c.r = float((s2[0] - s1[0])*mipSize);
+    c.g = float((s2[1] - s1[1])*mipSize);
+    c.b = float((s2[2] - s1[2])*mipSize);
+    c.a = float((s2[3] - s1[3])*mipSize);
+
+    std::copy(s2, s2 + 4, s1);
+  }
+
+  // each coarser level averages pairs of cells
+  for (size_t l = 1; l < levels.size(); ++l) {
+    const auto &colors1 = levels[l - 1];
+    auto       &colors2 = levels[l];
+
+    for (size_t i = size_t(i1 >> l); i <= size_t(i2 >> l); ++i) {
+      const auto &c1 = colors1[2*i    ];
+      const auto &c2 = colors1[2*i + 1];
+
+      auto &c = colors2[i];
+
+      c.r = 0.5f*(c1.r + c2.r);
+      c.g = 0.5f*(c1.g + c2.g);
+      c.b = 0.5f*(c1.b + c2.b);
+      c.a = 0.5f*(c1.a + c2.a);
+    }
+  }
+
+  mipData_.valid = true;
+}
+
+void
+CQColorsPalette::
+invalidateRange(double xmin, double xmax)
+{
+  xmin = CMathUtil::clamp(xmin, 0.0, 1.0);
+  xmax = CMathUtil::clamp(xmax, 0.0, 1.0);
+
+  // lookup table entries in range (automatic size may change so rebuild all)
+  if (lutData_.valid) {
+    if (lutMaxError() <= 0.0) {
+      auto n = int(lutData_.colors.size());
+
+      bakeLutRange(int(std::floor(xmin*(n - 1))), int(std::ceil(xmax*(n - 1))));
+    }
+    else
+      lutData_.valid = false;
+
+    lutData_.error = -1.0;
+  }
+
+  // integral samples in range and following sums (uses updated lookup table)
+  if (integralData_.valid)
+    updateIntegrals(int(std::floor(xmin*integralSteps)), int(std::ceil(xmax*integralSteps)));
+
+  // mip cells in range (and neighbors affected by integral sample interp)
+  if (mipData_.valid)
+    updateMipLevels(int(std::floor(xmin*mipSize)) - 1, int(std::ceil(xmax*mipSize)));
+
+  // integer table entries in range
+  for (int ind = 0; ind < 2*numIntTables; ++ind) {
+    auto *table = (ind < numIntTables ? &intTables_.tables8[ind] :
+                                        &intTables_.tables16[ind - numIntTables]);
+
+    if (! table->valid)
+      continue;
+
+    bool scale, invert, premultiplied;
+
+    intTableFlags(ind % numIntTables, scale, invert, premultiplied);
+
+    auto n = int(table->colors.size());
+
+    double x1, x2;
+
+    unmapColorRange(xmin, xmax, scale, invert, x1, x2);
+
+    int i1 = int(std::floor(std::max(x1, 0.0)*(n - 1)));
+    int i2 = int(std::ceil (std::min(x2, 1.0)*(n - 1)));
+
+    if (i1 > i2)
+      continue;
+
+    Reals x(size_t(i2 - i1 + 1));
+
+    for (int i = i1; i <= i2; ++i)
+      x[size_t(i - i1)] = i/(n - 1.0);
 
-  dc.c = c;
+    getColorsRgbT(evalData(), x.data(), int(x.size()), &table->colors[size_t(i1)],
+                  scale, invert, premultiplied);
+  }
+
+  // gradient image columns in range
+  if (! gradientImageDirty_) {
+    double x1, x2;
 
-  definedData_.definedValueColors[dc.v] = c;
+    unmapColorRange(xmin, xmax, false, false, x1, x2);
+
+    gradientDirtyMin_ = std::min(gradientDirtyMin_, x1);
+    gradientDirtyMax_ = std::max(gradientDirtyMax_, x2);
+  }
 }
 
 void
 CQColorsPalette::
-setDefinedColors(const ColorMap &cmap)
+unmapColorRange(double xmin, double xmax, bool scale, bool invert, double &x1, double &x2) const
 {
-  setColorType(ColorType::DEFINED);
+  // colors are clamped outside 0.0->1.0 so range at ends is unbounded
+  const double inf = std::numeric_limits<double>::infinity();
 
-  resetDefinedColors();
+  if (xmin <= 0.0) xmin = -inf;
+  if (xmax >= 1.0) xmax =  inf;
 
-  for (const auto &c : cmap)
-    addDefinedColor(c.first, c.second);
+  // map is linear (see mapColorX)
+  double m0 = mapColorX(0.0, scale, invert);
+  double m1 = mapColorX(1.0, scale, invert);
 
-  emit colorsChanged();
+  double d = m1 - m0;
 
-  gradientImageDirty_ = true;
+  if (d == 0.0) {
+    x1 = -inf;
+    x2 =  inf;
+    return;
+  }
+
+  x1 = (xmin - m0)/d;
+  x2 = (xmax - m0)/d;
+
+  if (x1 > x2)
+    std::swap(x1, x2);
 }
 
 void
 CQColorsPalette::
-setDefinedColors(const DefinedColors &colors)
+invalidate()
 {
-  setColorType(ColorType::DEFINED);
-
-  resetDefinedColors();
+  lutData_.valid = false;
 
-  for (const auto &c : colors)
-    addDefinedColor(c.v, c.c);
+  integralData_.valid = false;
+  mipData_     .valid = false;
 
-  emit colorsChanged();
+  invalidateIntTables();
 
   gradientImageDirty_ = true;
-}
 
-double
-CQColorsPalette::
-mapDefinedColorX(double x) const
-{
-  double d = definedData_.definedMax - definedData_.definedMin;
+  updateEvaluator();
 
-  return (d > 0.0 ? (x - definedData_.definedMin)/d : x);
+  emit colorsChanged();
 }
 
-double
+void
 CQColorsPalette::
-unmapDefinedColorX(double x) const
+invalidateIntTables()
 {
-  double d = definedData_.definedMax - definedData_.definedMin;
-
-  return x*d + definedData_.definedMin;
+  for (int i = 0; i < numIntTables; ++i) {
+    intTables_.tables8 [i].valid = false;
+    intTables_.tables16[i].valid = false;
+  }
 }
 
-bool
+void
 CQColorsPalette::
-isDistinct() const
+updateEvaluator()
 {
-  return definedData_.definedDistinct;
+  auto &evalData = evalData_;
+
+  // fold model negate and min/max into channel offset and scale
+  auto initChannel = [](ModelChannel &channel, int model, bool negative, double min, double max) {
+    channel.model = model;
+
+    if (negative) {
+      channel.offset = max;
+      channel.scale  = min - max;
+    }
+    else {
+      channel.offset = min;
+      channel.scale  = max - min;
+    }
+  };
+
+  initChannel(evalData.channels[0], redModel  (), isRedNegative  (), redMin  (), redMax  ());
+  initChannel(evalData.channels[1], greenModel(), isGreenNegative(), greenMin(), greenMax());
+  initChannel(evalData.channels[2], blueModel (), isBlueNegative (), blueMin (), blueMax ());
+
+  evalData.grayNegate = (isRedNegative() || isGreenNegative() || isBlueNegative());
+
+  updateGamma();
+
+  evalData.type         = colorType();
+  evalData.model        = colorModel();
+  evalData.defined      = &definedData_;
+  evalData.gray         = isGray();
+  evalData.gamma        = &gammaData_;
+  evalData.cubeHelix    = cubeHelix_;
+  evalData.cubeNegative = isCubeNegative();
+  evalData.lut          = (isLut() ? &lutData_ : nullptr);
+  evalData.palette      = this;
+
+  // batch table built here (not on first const use)
+  if (colorType() == ColorType::CUBEHELIX)
+    cubeHelix_->updateTable(isCubeNegative());
+
+  initEvaluator(evalData);
 }
 
 void
 CQColorsPalette::
-setDistinct(bool b)
+initEvaluator(EvalData &eval)
 {
-  definedData_.definedDistinct = b;
+  eval.proc = &CQColorsPalette::evalColor<EvalType::DEFAULT>;
 
-  emit colorsChanged();
+  if      (eval.lut) {
+    eval.proc = &CQColorsPalette::evalColor<EvalType::LUT>;
+  }
+  else if (eval.type == ColorType::DEFINED) {
+    const auto &defined = **eval.defined;
+
+    if      (defined.definedColors.empty())
+      eval.proc = &CQColorsPalette::evalColor<EvalType::DEFINED_EMPTY>;
+    else if (isSegmentInterp(defined))
+      eval.proc = &CQColorsPalette::evalColor<EvalType::DEFINED_SEGMENT>;
+    else if (eval.model == ColorModel::HSV)
+      eval.proc = &CQColorsPalette::evalColor<EvalType::DEFINED_HSV>;
+    else
+      eval.proc = &CQColorsPalette::evalColor<EvalType::DEFINED_RGB>;
+  }
+  else if (eval.type == ColorType::MODEL) {
+    if (eval.gray) {
+      eval.proc = &CQColorsPalette::evalColor<EvalType::MODEL_GRAY>;
+    }
+    else {
+      if      (eval.model == ColorModel::HSV)
+        eval.proc = &CQColorsPalette::evalColor<EvalType::MODEL_HSV>;
+      else if (linearModelMatrix(eval.model))
+        eval.proc = &CQColorsPalette::evalColor<EvalType::MODEL_LINEAR>;
+      else
+        eval.proc = &CQColorsPalette::evalColor<EvalType::MODEL_RGB>;
+    }
+  }
+  else if (eval.type == ColorType::CUBEHELIX) {
+    eval.proc = &CQColorsPalette::evalColor<EvalType::CUBEHELIX>;
+  }
 
-  gradientImageDirty_ = true;
+  // gamma correct evaluated color (lookup table colors are already corrected)
+  eval.baseProc = eval.proc;
+
+  if (! eval.gamma->values.empty() && ! eval.lut)
+    eval.proc = &CQColorsPalette::evalGammaColor;
 }
 
-bool
+QColor
 CQColorsPalette::
-isInverted() const
+evalGammaColor(const EvalData &eval, double x)
 {
-  return definedData_.definedInverted;
+  return gammaColor(*eval.gamma, eval.baseProc(eval, x));
 }
 
-void
+const CQColorsPalette::EvalData &
 CQColorsPalette::
-setInverted(bool b)
+evalData() const
 {
-  definedData_.definedInverted = b;
-
-  emit colorsChanged();
+  if (evalData_.lut && ! lutData_.valid)
+    updateLut();
 
-  gradientImageDirty_ = true;
+  return evalData_;
 }
 
-//---
-
-QColor
+void
 CQColorsPalette::
-getColor(int i, int n, WrapMode wrapMode) const
+updateGamma()
 {
-  assert(i >= 0);
-
-  if      (colorType() == ColorType::DEFINED) {
-    auto nc = definedData_.definedColors.size();
-    if (nc <= 0) return QColor();
-
-    if (isInverted())
-      i = n - 1 - i;
-
-    if      (wrapMode == WrapMode::REPEAT) {
-      while (i < 0)
-        i += nc;
-
-      while (i >= int(nc))
-        i -= nc;
-    }
-    else if (wrapMode == WrapMode::REFLECT) {
-      bool reflect = false;
+  auto &gammaData = gammaData_;
 
-      while (i < 0) {
-        i += nc;
-
-        reflect = ! reflect;
-      }
+  // no correction for gamma of one (or invalid gamma)
+  if (gamma_ == 1.0 || gamma_ <= 0.0) {
+    gammaData.values.clear();
 
-      while (i >= int(nc)) {
-        i -= nc;
+    gammaData.gamma = 1.0;
 
-        reflect = ! reflect;
-      }
+    return;
+  }
 
-      if (reflect)
-        i = int(nc - 1 - size_t(i));
-    }
-    else {
-      if (i < 0 || i >= int(nc))
-        return QColor();
-    }
+  if (gammaData.gamma == gamma_ && ! gammaData.values.empty())
+    return;
 
-    return definedColorData(i).c;
-  }
-  else {
-    if (n < 0)
-      n = defaultNumColors(); // TODO: default value
+  double e = 1.0/gamma_;
 
-    if (n <= 0)
-      return QColor();
+  gammaData.values.resize(gammaSteps + 1);
 
-    double r = (n > 1 ? 1.0*i/(n - 1) : 0.0);
+  for (int i = 0; i <= gammaSteps; ++i)
+    gammaData.values[size_t(i)] = float(std::pow(double(i)/gammaSteps, e));
 
-    return getColor(r);
-  }
+  gammaData.gamma = gamma_;
 }
 
-QColor
+double
 CQColorsPalette::
-getColor(double x, bool scale, bool invert) const
+gammaValue(const GammaData &data, double v)
 {
-  if      (colorType() == ColorType::DEFINED) {
-    if (definedData_.definedColors.empty()) {
-      QColor c1(Qt::black);
-      QColor c2(Qt::white);
-
-      if      (colorModel() == ColorModel::RGB)
-        return interpRGB(c1, c2, x);
-      else if (colorModel() == ColorModel::HSV)
-        return interpHSV(c1, c2, x);
-      else
-        return interpRGB(c1, c2, x);
-    }
+  // clamp to table range (NaN to zero)
+  v = (v > 0.0 ? std::min(v, 1.0) : 0.0);
 
-    if (scale)
-      x = mapDefinedColorX(x);
+  double s = v*gammaSteps;
 
-    if (invert)
-      x = 1.0 - x;
+  int i = std::min(int(s), gammaSteps - 1);
 
-    if (isInverted())
-      x = 1.0 - x;
+  // gamma > 1 has infinite slope at zero so calc first steps
+  if (i < 16 && data.gamma > 1.0)
+    return std::pow(v, 1.0/data.gamma);
 
-    auto p = definedData_.definedValueColors.begin();
+  const auto *values = &data.values[size_t(i)];
 
-    auto x1 = mapDefinedColorX((*p).first);
-    auto c1 = (*p).second;
+  return values[0] + (s - i)*(values[1] - values[0]);
+}
 
-    if (x <= x1) return c1;
+QColor
+CQColorsPalette::
+gammaColor(const GammaData &data, const QColor &c)
+{
+  if (data.values.empty())
+    return c;
 
-    for (++p; p != definedData_.definedValueColors.end(); ++p) {
-      auto x2 = mapDefinedColorX((*p).first);
-      auto c2 = (*p).second;
+  qreal r, g, b, a;
 
-      if (x <= x2) {
-        double m = (x - x1)/(x2 - x1);
+  c.getRgbF(&r, &g, &b, &a);
 
-        if      (colorModel() == ColorModel::RGB)
-          return interpRGB(c1, c2, m);
-        else if (colorModel() == ColorModel::HSV)
-          return interpHSV(c1, c2, m);
-        else
-          return interpRGB(c1, c2, m);
-      }
+  return QColor::fromRgbF(gammaValue(data, r), gammaValue(data, g), gammaValue(data, b), a);
+}
 
-      x1 = x2;
-      c1 = c2;
-    }
+template<CQColorsPalette::EvalType TYPE>
+QColor
+CQColorsPalette::
+evalColor(const EvalData &eval, double x)
+{
+  if      constexpr (TYPE == EvalType::LUT) {
+    auto c = lutColorF(eval.lut->colors, eval.lut->interp, x);
 
-    return c1;
+    return QColor::fromRgbF(c.r, c.g, c.b, c.a);
   }
-  else if (colorType() == ColorType::MODEL) {
-    if (isGray()) {
-      double g = CMathUtil::clamp(x, 0.0, 1.0);
+  else if constexpr (TYPE == EvalType::DEFINED_EMPTY) {
+    QColor c1(Qt::black);
+    QColor c2(Qt::white);
 
-      if (isRedNegative() || isGreenNegative() || isBlueNegative())
-        g = 1.0 - g;
+    return (eval.model == ColorModel::HSV ? interpHSV(c1, c2, x) : interpRGB(c1, c2, x));
+  }
+  else if constexpr (TYPE == EvalType::DEFINED_SEGMENT) {
+    const auto &defined = **eval.defined;
 
-      return QColor(int(255*g), int(255*g), int(255*g));
-    }
+    size_t i1, i2;
+    double m;
 
-    //---
+    definedSegment(defined.definedXValues, x, i1, i2, m);
 
-    double x1 = CMathUtil::clamp(x, 0.0, 1.0);
+    return interpDefinedColor(defined, eval.model, i1, i2, m);
+  }
+  else if constexpr (TYPE == EvalType::DEFINED_RGB || TYPE == EvalType::DEFINED_HSV) {
+    const auto &defined = **eval.defined;
 
-    double r = CMathUtil::clamp(interpModel(redModel  (), x1), 0.0, 1.0);
-    double g = CMathUtil::clamp(interpModel(greenModel(), x1), 0.0, 1.0);
-    double b = CMathUtil::clamp(interpModel(blueModel (), x1), 0.0, 1.0);
+    const auto &xcolors = defined.definedColors;
 
-    if (isRedNegative  ()) r = 1.0 - r;
-    if (isGreenNegative()) g = 1.0 - g;
-    if (isBlueNegative ()) b = 1.0 - b;
+    size_t i1, i2;
+    double m;
 
-    r = CMathUtil::map(r, 0.0, 1.0, redMin  (), redMax  ());
-    g = CMathUtil::map(g, 0.0, 1.0, greenMin(), greenMax());
-    b = CMathUtil::map(b, 0.0, 1.0, blueMin (), blueMax ());
+    definedSegment(defined.definedXValues, x, i1, i2, m);
 
-    QColor c;
+    if (i1 == i2)
+      return xcolors[i1];
 
-    if      (colorModel() == ColorModel::RGB)
-      c = QColor::fromRgbF(r, g, b);
-    else if (colorModel() == ColorModel::HSV)
-      c = QColor::fromHsvF(r, g, b);
+    if constexpr (TYPE == EvalType::DEFINED_HSV)
+      return interpHSV(xcolors[i1], xcolors[i2], m);
     else
-      c = QColor::fromRgbF(r, g, b);
-
-    return c;
+      return interpRGB(xcolors[i1], xcolors[i2], m);
   }
-  else if (colorType() == ColorType::FUNCTIONS) {
-    double r = 0.0, g = 0.0, b = 0.0;
-
-#ifdef CQCOLORS_TCL
-    auto *qtcl = this->qtcl();
+  else if constexpr (TYPE == EvalType::MODEL_GRAY) {
+    double g = CMathUtil::clamp(x, 0.0, 1.0);
 
-    qtcl->createVar("gray", x);
+    if (eval.grayNegate)
+      g = 1.0 - g;
 
-    QVariant res;
-    bool     ok;
+    // same rounding as batch colors (see getColors)
+    int gi = toByte(g);
 
-    if (qtcl->evalExpr(tclFnData_.rf.fn.c_str(), res))
-      r = CQTclUtil::toReal(res, ok);
+    return QColor(gi, gi, gi);
+  }
+  else if constexpr (TYPE == EvalType::MODEL_RGB || TYPE == EvalType::MODEL_HSV ||
+                     TYPE == EvalType::MODEL_LINEAR) {
+    double r, g, b;
 
-    if (qtcl->evalExpr(tclFnData_.gf.fn.c_str(), res))
-      g = CQTclUtil::toReal(res, ok);
+    modelRGB(eval.channels, x, r, g, b);
 
-    if (qtcl->evalExpr(tclFnData_.bf.fn.c_str(), res))
-      b = CQTclUtil::toReal(res, ok);
-#endif
+    // same float conversion and rounding as batch colors (see getColors)
+    if constexpr (TYPE == EvalType::MODEL_HSV || TYPE == EvalType::MODEL_LINEAR) {
+      float r1, g1, b1;
 
-    //---
+      if constexpr (TYPE == EvalType::MODEL_HSV)
+        hsvToRgbF(float(r), float(g), float(b), r1, g1, b1);
+      else
+        matrixToRgbF(linearModelMatrix(eval.model), float(r), float(g), float(b), r1, g1, b1);
 
-    QColor c;
+      r = r1; g = g1; b = b1;
+    }
 
-    r = CMathUtil::clamp(r, 0.0, 1.0);
-    g = CMathUtil::clamp(g, 0.0, 1.0);
-    b = CMathUtil::clamp(b, 0.0, 1.0);
+    return QColor(toByte(r), toByte(g), toByte(b));
+  }
+  else if constexpr (TYPE == EvalType::CUBEHELIX) {
+    // clamped and rounded as batch colors (see getColors)
+    double r, g, b;
 
-    if      (colorModel() == ColorModel::RGB)
-      c = QColor::fromRgbF(r, g, b);
-    else if (colorModel() == ColorModel::HSV)
-      c = QColor::fromHsvF(r, g, b);
-    else
-      c = QColor::fromRgbF(r, g, b);
+    eval.cubeHelix->interpRGB(x, r, g, b, eval.cubeNegative);
 
-    return c;
-  }
-  else if (colorType() == ColorType::CUBEHELIX) {
-    return QColor(cubeHelix()->interp(x, isCubeNegative()));
+    return QColor(toByte(r), toByte(g), toByte(b));
   }
   else {
-    return QColor(0, 0, 0);
+    // other color types (functions) from palette
+    return (eval.palette ? eval.palette->interpColor(x) : QColor(0, 0, 0));
   }
 }
 
@@ -722,6 +3029,105 @@ interpModel(int ind, double x)
   }
 }
 
+const float *
+CQColorsPalette::
+linearModelMatrix(ColorModel model)
+{
+  // gnuplot color model conversions
+  static const float cmyMatrix[] = {
+    -1.0f,  0.0f,  0.0f, 1.0f,
+     0.0f, -1.0f,  0.0f, 1.0f,
+     0.0f,  0.0f, -1.0f, 1.0f
+  };
+
+  static const float yiqMatrix[] = {
+    1.0f,  0.956f,  0.621f, 0.0f,
+    1.0f, -0.272f, -0.647f, 0.0f,
+    1.0f, -1.105f,  1.702f, 0.0f
+  };
+
+  static const float xyzMatrix[] = {
+     1.9100f, -0.5338f, -0.2891f, 0.0f,
+    -0.9844f,  1.9990f, -0.0279f, 0.0f,
+     0.0585f, -0.1187f,  0.9017f, 0.0f
+  };
+
+  switch (model) {
+    case ColorModel::CMY: return cmyMatrix;
+    case ColorModel::YIQ: return yiqMatrix;
+    case ColorModel::XYZ: return xyzMatrix;
+    default             : return nullptr;
+  }
+}
+
+void
+CQColorsPalette::
+modelToRgb(ColorModel model, double c1, double c2, double c3, double &r, double &g, double &b)
+{
+  if (model == ColorModel::HSV) {
+    hsvToRgb(c1, c2, c3, r, g, b);
+    return;
+  }
+
+  const auto *m = linearModelMatrix(model);
+
+  if (! m) {
+    r = c1; g = c2; b = c3;
+    return;
+  }
+
+  r = m[0]*c1 + m[1]*c2 + m[ 2]*c3 + m[ 3];
+  g = m[4]*c1 + m[5]*c2 + m[ 6]*c3 + m[ 7];
+  b = m[8]*c1 + m[9]*c2 + m[10]*c3 + m[11];
+}
+
+void
+CQColorsPalette::
+modelsToRgb(ColorModel model, const float *c1, const float *c2, const float *c3, int n,
+            float *r, float *g, float *b)
+{
+  const auto *matrix = linearModelMatrix(model);
+
+  bool rc = false;
+
+  if      (model == ColorModel::HSV)
+    rc = CQColorsSIMD::hsvToRgb(c1, c2, c3, n, r, g, b);
+  else if (matrix)
+    rc = CQColorsSIMD::transformRgb(matrix, c1, c2, c3, n, r, g, b);
+
+  // scalar float conversion (same results as vector kernels)
+  if (! rc) {
+    for (int i = 0; i < n; ++i) {
+      if      (model == ColorModel::HSV)
+        hsvToRgbF(c1[i], c2[i], c3[i], r[i], g[i], b[i]);
+      else if (matrix)
+        matrixToRgbF(matrix, c1[i], c2[i], c3[i], r[i], g[i], b[i]);
+      else {
+        r[i] = c1[i]; g[i] = c2[i]; b[i] = c3[i];
+      }
+    }
+  }
+}
+
+QColor
+CQColorsPalette::
+modelToColor(ColorModel model, double c1, double c2, double c3)
+{
+  double r, g, b;
+
+  modelToRgb(model, c1, c2, c3, r, g, b);
+
+  return QColor::fromRgbF(CMathUtil::clamp(r, 0.0, 1.0), CMathUtil::clamp(g, 0.0, 1.0),
+                          CMathUtil::clamp(b, 0.0, 1.0));
+}
+
+double
+CQColorsPalette::
+tableModel(int ind, double x)
+{
+  return ModelTable::instance().value(ind, x);
+}
+
 std::string
 CQColorsPalette::
 modelName(int ind)
@@ -862,6 +3268,8 @@ readFileLines(const QStringList &lines)
 
   resetDefinedColors();
 
+  DefinedColors colors;
+
   int i = 0;
 
   for (const auto &line : lines) {
@@ -883,7 +3291,7 @@ readFileLines(const QStringList &lines)
       ++j;
     }
 
-    double r, g, b;
+    double r, g, b, a = 1.0;
 
     if (words.size() >= 3) {
       bool ok;
@@ -891,15 +3299,21 @@ readFileLines(const QStringList &lines)
       r = words[j + 0].toDouble(&ok);
       g = words[j + 1].toDouble(&ok);
       b = words[j + 2].toDouble(&ok);
+
+      // optional alpha (after x)
+      if (words.size() >= 5)
+        a = words[j + 3].toDouble(&ok);
     }
     else
       continue;
 
-    addDefinedColor(x, QColor(int(255*r), int(255*g), int(255*b)));
+    colors.push_back(DefinedColor(x, QColor(int(255*r), int(255*g), int(255*b), int(255*a))));
 
     ++i;
   }
 
+  addDefinedColors(colors);
+
   return true;
 }
 
@@ -915,7 +3329,11 @@ saveFile(const std::string &filename)
 
     const auto &c = definedColor(i);
 
-    fprintf(fp, "%lf %lf %lf %lf\n", x, c.redF(), c.greenF(), c.blueF());
+    // alpha only written if not opaque
+    if (c.alpha() < 255)
+      fprintf(fp, "%lf %lf %lf %lf %lf\n", x, c.redF(), c.greenF(), c.blueF(), c.alphaF());
+    else
+      fprintf(fp, "%lf %lf %lf %lf\n", x, c.redF(), c.greenF(), c.blueF());
   }
 
   fclose(fp);
@@ -931,13 +3349,15 @@ unset()
   colorModel_ = ColorModel::RGB;
 
   // Model
-  modelData_.rModel        = 7;
-  modelData_.gModel        = 5;
-  modelData_.bModel        = 15;
-  modelData_.gray          = false;
-  modelData_.redNegative   = false;
-  modelData_.greenNegative = false;
-  modelData_.blueNegative  = false;
+  auto &modelData = modelData_.edit();
+
+  modelData.rModel        = 7;
+  modelData.gModel        = 5;
+  modelData.bModel        = 15;
+  modelData.gray          = false;
+  modelData.redNegative   = false;
+  modelData.greenNegative = false;
+  modelData.blueNegative  = false;
 
   // Defined
   resetDefinedColors();
@@ -946,13 +3366,24 @@ unset()
   initFunctions();
 
   // CubeHelix
-  if (cubeHelix_)
-    cubeHelix_->reset();
+  cubeHelix_->reset();
 
   // Gamma
-#if 0
-  gamma_ = 1.5;
-#endif
+  gamma_ = 1.0;
+
+  invalidate();
+}
+
+void
+CQColorsPalette::
+setGradientFiltered(bool b)
+{
+  if (b == gradientFiltered_)
+    return;
+
+  gradientFiltered_ = b;
+
+  gradientImageDirty_ = true;
 }
 
 QImage
@@ -965,8 +3396,11 @@ getGradientImage(const QSize &size)
     gradientImageDirty_ = true;
   }
 
-  if (gradientImageDirty_) {
-    gradientImage_.fill(Qt::transparent);
+  bool rangeDirty = (gradientDirtyMin_ <= gradientDirtyMax_);
+
+  if (gradientImageDirty_ || rangeDirty) {
+    if (gradientImageDirty_)
+      gradientImage_.fill(Qt::transparent);
 
     int w = size.width ();
     int h = size.height();
@@ -974,10 +3408,31 @@ getGradientImage(const QSize &size)
     if (w > 1) {
       QPainter painter(&gradientImage_);
 
+      // replace (partially redrawn) column pixels
+      painter.setCompositionMode(QPainter::CompositionMode_Source);
+
+      Sampler sampler(this);
+
+      // pre-filtered colors (if enabled) if palette has more detail than pixels
+      double footprint = 1.0/(w - 1.0);
+
+      int level = (isGradientFiltered() ? mipLevel(footprint) : -1);
+
+      bool minified = (level >= 0);
+
+      // changed range (extended by filter footprint)
+      double pad = (minified ? 2.0/(mipSize >> level) : footprint);
+
+      double xmin = gradientDirtyMin_ - pad;
+      double xmax = gradientDirtyMax_ + pad;
+
       for (int i = 0; i < w; ++i) {
         double x = i/(w - 1.0);
 
-        auto c = getColor(x);
+        if (! gradientImageDirty_ && (x < xmin || x > xmax))
+          continue;
+
+        auto c = (minified ? getMipColor(x, footprint) : sampler.getColor(x));
 
         QPen pen(c);
 
@@ -990,6 +3445,9 @@ getGradientImage(const QSize &size)
     }
 
     gradientImageDirty_ = false;
+
+    gradientDirtyMin_ = 1.0;
+    gradientDirtyMax_ = 0.0;
   }
 
   return gradientImage_;
@@ -1013,8 +3471,10 @@ setLinearGradient(QLinearGradient &lg, double a, double xmin, double xmax, bool
 
   double x = xmin;
 
+  Sampler sampler(this);
+
   for (int i = 0; i < n; ++i) {
-    auto c = getColor(x);
+    auto c = sampler.getColor(x);
 
     if (! enabled)
       c = grayColor(c);
@@ -1067,9 +3527,7 @@ show(std::ostream &os) const
   else if (colorModel() == ColorModel::XYZ) os << "XYZ";
   os << std::endl;
 
-#if 0
   os << "gamma is " << gamma_ << std::endl;
-#endif
 }
 
 void
@@ -0,0 +1,181 @@
+#include <CQColorsPaletteSnapshot.h>
+
+#include <algorithm>
+
+namespace {
+
+// baked lookup table size for function palettes (no interpreter on worker threads)
+const int functionLutSize = 1025;
+
+}
+
+CQColorsPaletteSnapshot::
+CQColorsPaletteSnapshot(const CQColorsPalette &palette)
+{
+  auto data = std::make_shared<Data>();
+
+  const auto &peval = palette.evalData();
+
+  data->defined   = palette.definedData_;
+  data->gamma     = palette.gammaData_;
+  data->cubeHelix = *palette.cubeHelix();
+
+  auto &eval = data->eval;
+
+  eval.type  = peval.type;
+  eval.model = peval.model;
+
+  for (int i = 0; i < 3; ++i)
+    eval.channels[i] = peval.channels[i];
+
+  eval.gray         = peval.gray;
+  eval.grayNegate   = peval.grayNegate;
+  eval.cubeNegative = peval.cubeNegative;
+
+  eval.defined   = &data->defined;
+  eval.gamma     = &data->gamma;
+  eval.cubeHelix = &data->cubeHelix;
+
+  if (eval.type == ColorType::CUBEHELIX)
+    data->cubeHelix.updateTable(eval.cubeNegative);
+
+  // copy baked lookup table (colors are gamma corrected)
+  if      (peval.lut) {
+    data->lut.colors = peval.lut->colors;
+    data->lut.interp = peval.lut->interp;
+
+    eval.lut = &data->lut;
+  }
+  else if (eval.type == ColorType::FUNCTIONS) {
+    CQColorsPalette::Reals x(functionLutSize);
+
+    for (int i = 0; i < functionLutSize; ++i)
+      x[size_t(i)] = i/(functionLutSize - 1.0);
+
+    data->lut.colors.resize(functionLutSize);
+
+    palette.getColorsF(x.data(), functionLutSize, data->lut.colors.data());
+
+    eval.lut = &data->lut;
+  }
+
+  Palette::initEvaluator(eval);
+
+  data_ = data;
+}
+
+bool
+CQColorsPaletteSnapshot::
+hasAlpha() const
+{
+  return (data_ && Palette::hasAlpha(data_->eval));
+}
+
+//---
+
+QColor
+CQColorsPaletteSnapshot::
+getColor(double x, bool scale, bool invert) const
+{
+  if (! data_)
+    return QColor(0, 0, 0);
+
+  const auto &eval = data_->eval;
+
+  return eval.proc(eval, Palette::mapColorX(eval, x, scale, invert));
+}
+
+CQColorsPaletteSnapshot::ColorF
+CQColorsPaletteSnapshot::
+getColorF(double x, bool scale, bool invert) const
+{
+  ColorF c;
+
+  getColorsF(&x, 1, &c, scale, invert);
+
+  return c;
+}
+
+void
+CQColorsPaletteSnapshot::
+getColors(const double *x, int n, QRgb *rgb, bool scale, bool invert, bool premultiplied) const
+{
+  if (! data_)
+    std::fill(rgb, rgb + n, qRgb(0, 0, 0));
+  else
+    Palette::getColorsRgbT(data_->eval, x, n, rgb, scale, invert, premultiplied);
+}
+
+void
+CQColorsPaletteSnapshot::
+getColors(const float *x, int n, QRgb *rgb, bool scale, bool invert, bool premultiplied) const
+{
+  if (! data_)
+    std::fill(rgb, rgb + n, qRgb(0, 0, 0));
+  else
+    Palette::getColorsRgbT(data_->eval, x, n, rgb, scale, invert, premultiplied);
+}
+
+void
+CQColorsPaletteSnapshot::
+getColorsF(const double *x, int n, ColorF *c, bool scale, bool invert) const
+{
+  if (! data_)
+    std::fill(c, c + n, ColorF());
+  else
+    Palette::getColorsT(data_->eval, x, n, c, scale, invert);
+}
+
+void
+CQColorsPaletteSnapshot::
+getColorsF(const float *x, int n, ColorF *c, bool scale, bool invert) const
+{
+  if (! data_)
+    std::fill(c, c + n, ColorF());
+  else
+    Palette::getColorsT(data_->eval, x, n, c, scale, invert);
+}
+
+void
+CQColorsPaletteSnapshot::
+getColors(const uint8_t *v, int n, QRgb *rgb, bool scale, bool invert, bool premultiplied) const
+{
+  if (! data_) {
+    std::fill(rgb, rgb + n, qRgb(0, 0, 0));
+    return;
+  }
+
+  const auto *table = Palette::intTable(data_->eval, data_->intTables, 8,
+                                        scale, invert, premultiplied);
+
+  for (int i = 0; i < n; ++i)
+    rgb[i] = table[v[i]];
+}
+
+void
+CQColorsPaletteSnapshot::
+getColors(const uint16_t *v, int n, QRgb *rgb, bool scale, bool invert,
+          bool premultiplied) const
+{
+  if (! data_) {
+    std::fill(rgb, rgb + n, qRgb(0, 0, 0));
+    return;
+  }
+
+  const auto *table = Palette::intTable(data_->eval, data_->intTables, 16,
+                                        scale, invert, premultiplied);
+
+  for (int i = 0; i < n; ++i)
+    rgb[i] = table[v[i]];
+}
+
+QImage
+CQColorsPaletteSnapshot::
+colorizeImage(const QImage &image, bool scale, bool invert, bool premultiplied) const
+{
+  if (! data_)
+    return QImage();
+
+  return Palette::colorizeImage(data_->eval, data_->intTables, image, scale, invert,
+                                premultiplied);
+}
@@ -0,0 +1,591 @@
+#include <CQColorsSIMD.h>
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CQCOLORS_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+std::atomic<int> s_maxLevel { int(CQColorsSIMD::Level::AVX2) };
+
+CQColorsSIMD::Level cpuLevel() {
+#ifdef CQCOLORS_SIMD_X86
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2"  )) return CQColorsSIMD::Level::AVX2;
+  if (__builtin_cpu_supports("sse4.1")) return CQColorsSIMD::Level::SSE4;
+#endif
+
+  return CQColorsSIMD::Level::NONE;
+}
+
+#ifdef CQCOLORS_SIMD_X86
+
+// max stops for segment search by counting (else binary search)
+const int maxCountStops = 32;
+
+//------
+// AVX2 (8 lanes)
+//------
+
+__attribute__((target("avx2")))
+inline __m256 avx2Clamp01(__m256 v) {
+  return _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+}
+
+// find segment index for x values (branchless binary search over positions)
+__attribute__((target("avx2")))
+inline __m256i avx2Segment(const CQColorsSIMD::Stops &stops, __m256 &x) {
+  auto lo = _mm256_set1_ps(stops.x[0]);
+  auto hi = _mm256_set1_ps(stops.x[stops.n - 1]);
+
+  // clamp to stop range (NaN maps to last stop)
+  x = _mm256_max_ps(_mm256_min_ps(x, hi), lo);
+
+  // last position < x in [0, n - 2]
+  auto base = _mm256_setzero_si256();
+
+  // few stops so count positions < x (no gathers)
+  if (stops.n <= maxCountStops) {
+    for (int k = 1; k < stops.n - 1; ++k) {
+      auto lt = _mm256_cmp_ps(_mm256_set1_ps(stops.x[k]), x, _CMP_LT_OQ);
+
+      base = _mm256_sub_epi32(base, _mm256_castps_si256(lt));
+    }
+
+    return base;
+  }
+
+  int len = stops.n - 1;
+
+  while (len > 1) {
+    int half = len/2;
+
+    auto ind = _mm256_add_epi32(base, _mm256_set1_epi32(half));
+    auto lt  = _mm256_cmp_ps(_mm256_i32gather_ps(stops.x, ind, 4), x, _CMP_LT_OQ);
+
+    base = _mm256_blendv_epi8(base, ind, _mm256_castps_si256(lt));
+
+    len -= half;
+  }
+
+  return base;
+}
+
+// load segment records for each lane and transpose to per field values
+__attribute__((target("avx2")))
+inline void avx2LoadSegments(const float *segments, __m256i ind, __m256 r[8]) {
+  alignas(32) int i[8];
+
+  _mm256_store_si256(reinterpret_cast<__m256i *>(i), ind);
+
+  for (int k = 0; k < 8; ++k)
+    r[k] = _mm256_loadu_ps(segments + 8*i[k]);
+
+  auto t0 = _mm256_unpacklo_ps(r[0], r[1]);
+  auto t1 = _mm256_unpackhi_ps(r[0], r[1]);
+  auto t2 = _mm256_unpacklo_ps(r[2], r[3]);
+  auto t3 = _mm256_unpackhi_ps(r[2], r[3]);
+  auto t4 = _mm256_unpacklo_ps(r[4], r[5]);
+  auto t5 = _mm256_unpackhi_ps(r[4], r[5]);
+  auto t6 = _mm256_unpacklo_ps(r[6], r[7]);
+  auto t7 = _mm256_unpackhi_ps(r[6], r[7]);
+
+  auto s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+  auto s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+  auto s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  auto s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  auto s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+  auto s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+  auto s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+  auto s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+  r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+  r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+  r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+  r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+  r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+  r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+  r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+  r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+// interpolate three channels at x
+__attribute__((target("avx2")))
+inline void avx2Interp(const CQColorsSIMD::Stops &stops, const float *px,
+                       __m256 &c1, __m256 &c2, __m256 &c3) {
+  auto x = _mm256_loadu_ps(px);
+
+  auto ind = avx2Segment(stops, x);
+
+  __m256 r[8];
+
+  avx2LoadSegments(stops.segments, ind, r);
+
+  auto m = avx2Clamp01(_mm256_mul_ps(_mm256_sub_ps(x, r[0]), r[1]));
+
+  c1 = _mm256_add_ps(r[2], _mm256_mul_ps(r[3], m));
+  c2 = _mm256_add_ps(r[4], _mm256_mul_ps(r[5], m));
+  c3 = _mm256_add_ps(r[6], _mm256_mul_ps(r[7], m));
+}
+
+__attribute__((target("avx2")))
+inline __m256i avx2Pack(__m256 r, __m256 g, __m256 b) {
+  auto s    = _mm256_set1_ps(255.0f);
+  auto half = _mm256_set1_ps(0.5f);
+
+  auto ri = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(avx2Clamp01(r), s), half));
+  auto gi = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(avx2Clamp01(g), s), half));
+  auto bi = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(avx2Clamp01(b), s), half));
+
+  auto rgb = _mm256_or_si256(_mm256_slli_epi32(ri, 16), _mm256_slli_epi32(gi, 8));
+
+  return _mm256_or_si256(_mm256_or_si256(rgb, bi), _mm256_set1_epi32(int(0xff000000)));
+}
+
+// select one of six values by integer valued float index (0-5)
+__attribute__((target("avx2")))
+inline __m256 avx2Select6(__m256 i, __m256 v0, __m256 v1, __m256 v2,
+                          __m256 v3, __m256 v4, __m256 v5) {
+  auto res = v0;
+
+  res = _mm256_blendv_ps(res, v1, _mm256_cmp_ps(i, _mm256_set1_ps(1.0f), _CMP_EQ_OQ));
+  res = _mm256_blendv_ps(res, v2, _mm256_cmp_ps(i, _mm256_set1_ps(2.0f), _CMP_EQ_OQ));
+  res = _mm256_blendv_ps(res, v3, _mm256_cmp_ps(i, _mm256_set1_ps(3.0f), _CMP_EQ_OQ));
+  res = _mm256_blendv_ps(res, v4, _mm256_cmp_ps(i, _mm256_set1_ps(4.0f), _CMP_EQ_OQ));
+  res = _mm256_blendv_ps(res, v5, _mm256_cmp_ps(i, _mm256_set1_ps(5.0f), _CMP_EQ_OQ));
+
+  return res;
+}
+
+__attribute__((target("avx2")))
+inline void avx2HsvToRgb(__m256 h, __m256 s, __m256 v, __m256 &r, __m256 &g, __m256 &b) {
+  auto one = _mm256_set1_ps(1.0f);
+
+  auto h6 = _mm256_mul_ps(h, _mm256_set1_ps(6.0f));
+
+  // hue of 1.0 is same as 0.0
+  h6 = _mm256_andnot_ps(_mm256_cmp_ps(h6, _mm256_set1_ps(6.0f), _CMP_GE_OQ), h6);
+
+  auto i = _mm256_floor_ps(h6);
+  auto f = _mm256_sub_ps(h6, i);
+
+  auto p = _mm256_mul_ps(v, _mm256_sub_ps(one, s));
+  auto q = _mm256_mul_ps(v, _mm256_sub_ps(one, _mm256_mul_ps(s, f)));
+  auto t = _mm256_mul_ps(v, _mm256_sub_ps(one, _mm256_mul_ps(s, _mm256_sub_ps(one, f))));
+
+  r = avx2Select6(i, v, q, p, p, t, v);
+  g = avx2Select6(i, t, v, v, q, p, p);
+  b = avx2Select6(i, p, p, t, v, v, q);
+}
+
+__attribute__((target("avx2")))
+void avx2InterpRGB(const CQColorsSIMD::Stops &stops, const float *x, QRgb *rgb) {
+  __m256 r, g, b;
+
+  avx2Interp(stops, x, r, g, b);
+
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(rgb), avx2Pack(r, g, b));
+}
+
+__attribute__((target("avx2")))
+void avx2InterpHSV(const CQColorsSIMD::Stops &stops, const float *x, QRgb *rgb) {
+  __m256 h, s, v;
+
+  avx2Interp(stops, x, h, s, v);
+
+  __m256 r, g, b;
+
+  avx2HsvToRgb(h, s, v, r, g, b);
+
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(rgb), avx2Pack(r, g, b));
+}
+
+//------
+// SSE4.1 (4 lanes)
+//------
+
+__attribute__((target("sse4.1")))
+inline __m128 sse4Clamp01(__m128 v) {
+  return _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+}
+
+__attribute__((target("sse4.1")))
+inline __m128 sse4Gather(const float *p, __m128i ind) {
+  return _mm_setr_ps(p[_mm_extract_epi32(ind, 0)], p[_mm_extract_epi32(ind, 1)],
+                     p[_mm_extract_epi32(ind, 2)], p[_mm_extract_epi32(ind, 3)]);
+}
+
+__attribute__((target("sse4.1")))
+inline __m128i sse4Segment(const CQColorsSIMD::Stops &stops, __m128 &x) {
+  auto lo = _mm_set1_ps(stops.x[0]);
+  auto hi = _mm_set1_ps(stops.x[stops.n - 1]);
+
+  x = _mm_max_ps(_mm_min_ps(x, hi), lo);
+
+  auto base = _mm_setzero_si128();
+
+  if (stops.n <= maxCountStops) {
+    for (int k = 1; k < stops.n - 1; ++k) {
+      auto lt = _mm_cmplt_ps(_mm_set1_ps(stops.x[k]), x);
+
+      base = _mm_sub_epi32(base, _mm_castps_si128(lt));
+    }
+
+    return base;
+  }
+
+  int len = stops.n - 1;
+
+  while (len > 1) {
+    int half = len/2;
+
+    auto ind = _mm_add_epi32(base, _mm_set1_epi32(half));
+    auto lt  = _mm_cmplt_ps(sse4Gather(stops.x, ind), x);
+
+    base = _mm_blendv_epi8(base, ind, _mm_castps_si128(lt));
+
+    len -= half;
+  }
+
+  return base;
+}
+
+__attribute__((target("sse4.1")))
+inline void sse4Interp(const CQColorsSIMD::Stops &stops, const float *px,
+                       __m128 &c1, __m128 &c2, __m128 &c3) {
+  auto x = _mm_loadu_ps(px);
+
+  auto ind = sse4Segment(stops, x);
+
+  // load and transpose low (x, 1/dx, c1, dc1) and high (c2, dc2, c3, dc3) halves of records
+  alignas(16) int i[4];
+
+  _mm_store_si128(reinterpret_cast<__m128i *>(i), ind);
+
+  __m128 l[4], h[4];
+
+  for (int k = 0; k < 4; ++k) {
+    l[k] = _mm_loadu_ps(stops.segments + 8*i[k]    );
+    h[k] = _mm_loadu_ps(stops.segments + 8*i[k] + 4);
+  }
+
+  _MM_TRANSPOSE4_PS(l[0], l[1], l[2], l[3]);
+  _MM_TRANSPOSE4_PS(h[0], h[1], h[2], h[3]);
+
+  auto m = sse4Clamp01(_mm_mul_ps(_mm_sub_ps(x, l[0]), l[1]));
+
+  c1 = _mm_add_ps(l[2], _mm_mul_ps(l[3], m));
+  c2 = _mm_add_ps(h[0], _mm_mul_ps(h[1], m));
+  c3 = _mm_add_ps(h[2], _mm_mul_ps(h[3], m));
+}
+
+__attribute__((target("sse4.1")))
+inline __m128i sse4Pack(__m128 r, __m128 g, __m128 b) {
+  auto s    = _mm_set1_ps(255.0f);
+  auto half = _mm_set1_ps(0.5f);
+
+  auto ri = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(sse4Clamp01(r), s), half));
+  auto gi = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(sse4Clamp01(g), s), half));
+  auto bi = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(sse4Clamp01(b), s), half));
+
+  auto rgb = _mm_or_si128(_mm_slli_epi32(ri, 16), _mm_slli_epi32(gi, 8));
+
+  return _mm_or_si128(_mm_or_si128(rgb, bi), _mm_set1_epi32(int(0xff000000)));
+}
+
+__attribute__((target("sse4.1")))
+inline __m128 sse4Select6(__m128 i, __m128 v0, __m128 v1, __m128 v2,
+                          __m128 v3, __m128 v4, __m128 v5) {
+  auto res = v0;
+
+  res = _mm_blendv_ps(res, v1, _mm_cmpeq_ps(i, _mm_set1_ps(1.0f)));
+  res = _mm_blendv_ps(res, v2, _mm_cmpeq_ps(i, _mm_set1_ps(2.0f)));
+  res = _mm_blendv_ps(res, v3, _mm_cmpeq_ps(i, _mm_set1_ps(3.0f)));
+  res = _mm_blendv_ps(res, v4, _mm_cmpeq_ps(i, _mm_set1_ps(4.0f)));
+  res = _mm_blendv_ps(res, v5, _mm_cmpeq_ps(i, _mm_set1_ps(5.0f)));
+
+  return res;
+}
+
+__attribute__((target("sse4.1")))
+inline void sse4HsvToRgb(__m128 h, __m128 s, __m128 v, __m128 &r, __m128 &g, __m128 &b) {
+  auto one = _mm_set1_ps(1.0f);
+
+  auto h6 = _mm_mul_ps(h, _mm_set1_ps(6.0f));
+
+  h6 = _mm_andnot_ps(_mm_cmpge_ps(h6, _mm_set1_ps(6.0f)), h6);
+
+  auto i = _mm_floor_ps(h6);
+  auto f = _mm_sub_ps(h6, i);
+
+  auto p = _mm_mul_ps(v, _mm_sub_ps(one, s));
+  auto q = _mm_mul_ps(v, _mm_sub_ps(one, _mm_mul_ps(s, f)));
+  auto t = _mm_mul_ps(v, _mm_sub_ps(one, _mm_mul_ps(s, _mm_sub_ps(one, f))));
+
+  r = sse4Select6(i, v, q, p, p, t, v);
+  g = sse4Select6(i, t, v, v, q, p, p);
+  b = sse4Select6(i, p, p, t, v, v, q);
+}
+
+__attribute__((target("sse4.1")))
+void sse4InterpRGB(const CQColorsSIMD::Stops &stops, const float *x, QRgb *rgb) {
+  __m128 r, g, b;
+
+  sse4Interp(stops, x, r, g, b);
+
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(rgb), sse4Pack(r, g, b));
+}
+
+__attribute__((target("sse4.1")))
+void sse4InterpHSV(const CQColorsSIMD::Stops &stops, const float *x, QRgb *rgb) {
+  __m128 h, s, v;
+
+  sse4Interp(stops, x, h, s, v);
+
+  __m128 r, g, b;
+
+  sse4HsvToRgb(h, s, v, r, g, b);
+
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(rgb), sse4Pack(r, g, b));
+}
+
+//---
+
+// color conversion kernels (separate channel arrays, matrix is unused for hsv)
+
+__attribute__((target("avx2")))
+void avx2HsvToRgbArrays(const float *, const float *h, const float *s, const float *v,
+                        float *r, float *g, float *b) {
+  __m256 rv, gv, bv;
+
+  avx2HsvToRgb(_mm256_loadu_ps(h), _mm256_loadu_ps(s), _mm256_loadu_ps(v), rv, gv, bv);
+
+  _mm256_storeu_ps(r, rv);
+  _mm256_storeu_ps(g, gv);
+  _mm256_storeu_ps(b, bv);
+}
+
+// affine matrix row (three scales and offset) applied to three values
+__attribute__((target("avx2")))
+inline __m256 avx2MatrixRow(const float *m, __m256 v1, __m256 v2, __m256 v3) {
+  auto res = _mm256_set1_ps(m[3]);
+
+  res = _mm256_add_ps(res, _mm256_mul_ps(_mm256_set1_ps(m[0]), v1));
+  res = _mm256_add_ps(res, _mm256_mul_ps(_mm256_set1_ps(m[1]), v2));
+  res = _mm256_add_ps(res, _mm256_mul_ps(_mm256_set1_ps(m[2]), v3));
+
+  return res;
+}
+
+__attribute__((target("avx2")))
+void avx2TransformArrays(const float *m, const float *c1, const float *c2, const float *c3,
+                         float *r, float *g, float *b) {
+  auto v1 = _mm256_loadu_ps(c1);
+  auto v2 = _mm256_loadu_ps(c2);
+  auto v3 = _mm256_loadu_ps(c3);
+
+  _mm256_storeu_ps(r, avx2MatrixRow(m    , v1, v2, v3));
+  _mm256_storeu_ps(g, avx2MatrixRow(m + 4, v1, v2, v3));
+  _mm256_storeu_ps(b, avx2MatrixRow(m + 8, v1, v2, v3));
+}
+
+__attribute__((target("sse4.1")))
+void sse4HsvToRgbArrays(const float *, const float *h, const float *s, const float *v,
+                        float *r, float *g, float *b) {
+  __m128 rv, gv, bv;
+
+  sse4HsvToRgb(_mm_loadu_ps(h), _mm_loadu_ps(s), _mm_loadu_ps(v), rv, gv, bv);
+
+  _mm_storeu_ps(r, rv);
+  _mm_storeu_ps(g, gv);
+  _mm_storeu_ps(b, bv);
+}
+
+__attribute__((target("sse4.1")))
+inline __m128 sse4MatrixRow(const float *m, __m128 v1, __m128 v2, __m128 v3) {
+  auto res = _mm_set1_ps(m[3]);
+
+  res = _mm_add_ps(res, _mm_mul_ps(_mm_set1_ps(m[0]), v1));
+  res = _mm_add_ps(res, _mm_mul_ps(_mm_set1_ps(m[1]), v2));
+  res = _mm_add_ps(res, _mm_mul_ps(_mm_set1_ps(m[2]), v3));
+
+  return res;
+}
+
+__attribute__((target("sse4.1")))
+void sse4TransformArrays(const float *m, const float *c1, const float *c2, const float *c3,
+                         float *r, float *g, float *b) {
+  auto v1 = _mm_loadu_ps(c1);
+  auto v2 = _mm_loadu_ps(c2);
+  auto v3 = _mm_loadu_ps(c3);
+
+  _mm_storeu_ps(r, sse4MatrixRow(m    , v1, v2, v3));
+  _mm_storeu_ps(g, sse4MatrixRow(m + 4, v1, v2, v3));
+  _mm_storeu_ps(b, sse4MatrixRow(m + 8, v1, v2, v3));
+}
+
+//---
+
+using Kernel = void (*)(const CQColorsSIMD::Stops &stops, const float *x, QRgb *rgb);
+
+// run kernel over full vectors and pad remainder
+void runKernel(Kernel kernel, int lanes, const CQColorsSIMD::Stops &stops,
+               const float *x, int n, QRgb *rgb) {
+  int i = 0;
+
+  for ( ; i + lanes <= n; i += lanes)
+    kernel(stops, x + i, rgb + i);
+
+  if (i < n) {
+    float xt[8];
+    QRgb  rt[8];
+
+    int nt = n - i;
+
+    std::copy(x + i, x + n, xt);
+    std::fill(xt + nt, xt + lanes, 0.0f);
+
+    kernel(stops, xt, rt);
+
+    std::copy(rt, rt + nt, rgb + i);
+  }
+}
+
+using ConvKernel = void (*)(const float *matrix, const float *c1, const float *c2,
+                            const float *c3, float *r, float *g, float *b);
+
+// run color conversion kernel over full vectors and pad remainder
+void runConvKernel(ConvKernel kernel, int lanes, const float *matrix, const float *c1,
+                   const float *c2, const float *c3, int n, float *r, float *g, float *b) {
+  int i = 0;
+
+  for ( ; i + lanes <= n; i += lanes)
+    kernel(matrix, c1 + i, c2 + i, c3 + i, r + i, g + i, b + i);
+
+  if (i < n) {
+    float ct1[8] = {}, ct2[8] = {}, ct3[8] = {};
+    float rt[8], gt[8], bt[8];
+
+    int nt = n - i;
+
+    std::copy(c1 + i, c1 + n, ct1);
+    std::copy(c2 + i, c2 + n, ct2);
+    std::copy(c3 + i, c3 + n, ct3);
+
+    kernel(matrix, ct1, ct2, ct3, rt, gt, bt);
+
+    std::copy(rt, rt + nt, r + i);
+    std::copy(gt, gt + nt, g + i);
+    std::copy(bt, bt + nt, b + i);
+  }
+}
+
+#endif
+
+}
+
+//------
+
+namespace CQColorsSIMD {
+
+Level
+level()
+{
+  static Level cpu = cpuLevel();
+
+  return Level(std::min(int(cpu), s_maxLevel.load()));
+}
+
+Level
+maxLevel()
+{
+  return Level(s_maxLevel.load());
+}
+
+void
+setMaxLevel(Level level)
+{
+  s_maxLevel = int(level);
+}
+
+bool
+interpRGB(const Stops &stops, const float *x, int n, QRgb *rgb)
+{
+  if (stops.n < 2)
+    return false;
+
+#ifdef CQCOLORS_SIMD_X86
+  switch (level()) {
+    case Level::AVX2: runKernel(avx2InterpRGB, 8, stops, x, n, rgb); return true;
+    case Level::SSE4: runKernel(sse4InterpRGB, 4, stops, x, n, rgb); return true;
+    default: break;
+  }
+#else
+  (void) x; (void) n; (void) rgb;
+#endif
+
+  return false;
+}
+
+bool
+interpHSV(const Stops &stops, const float *x, int n, QRgb *rgb)
+{
+  if (stops.n < 2)
+    return false;
+
+#ifdef CQCOLORS_SIMD_X86
+  switch (level()) {
+    case Level::AVX2: runKernel(avx2InterpHSV, 8, stops, x, n, rgb); return true;
+    case Level::SSE4: runKernel(sse4InterpHSV, 4, stops, x, n, rgb); return true;
+    default: break;
+  }
+#else
+  (void) x; (void) n; (void) rgb;
+#endif
+
+  return false;
+}
+
+bool
+hsvToRgb(const float *h, const float *s, const float *v, int n, float *r, float *g, float *b)
+{
+#ifdef CQCOLORS_SIMD_X86
+  switch (level()) {
+    case Level::AVX2:
+      runConvKernel(avx2HsvToRgbArrays, 8, nullptr, h, s, v, n, r, g, b); return true;
+    case Level::SSE4:
+      runConvKernel(sse4HsvToRgbArrays, 4, nullptr, h, s, v, n, r, g, b); return true;
+    default: break;
+  }
+#else
+  (void) h; (void) s; (void) v; (void) n; (void) r; (void) g; (void) b;
+#endif
+
+  return false;
+}
+
+bool
+transformRgb(const float *matrix, const float *c1, const float *c2, const float *c3,
+             int n, float *r, float *g, float *b)
+{
+#ifdef CQCOLORS_SIMD_X86
+  switch (level()) {
+    case Level::AVX2:
+      runConvKernel(avx2TransformArrays, 8, matrix, c1, c2, c3, n, r, g, b); return true;
+    case Level::SSE4:
+      runConvKernel(sse4TransformArrays, 4, matrix, c1, c2, c3, n, r, g, b); return true;
+    default: break;
+  }
+#else
+  (void) matrix; (void) c1; (void) c2; (void) c3; (void) n; (void) r; (void) g; (void) b;
+#endif
+
+  return false;
+}
+
+}
@@ -0,0 +1,176 @@
+#include <CQColorsPalette.h>
+#include <CQColorsSIMD.h>
+
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// compare batch (getColors) and single (getColor) colors for every color model
+// and vector kernel (SIMD) and scalar batch colors for defined colors
+namespace {
+
+const int numTestValues = 2001;
+
+void testValues(std::vector<double> &x) {
+  x.resize(numTestValues);
+
+  // include values outside range
+  for (int i = 0; i < numTestValues; ++i)
+    x[size_t(i)] = -0.25 + 1.5*i/(numTestValues - 1);
+}
+
+int rgbDiff(QRgb c1, QRgb c2) {
+  int d = std::abs(qRed(c1) - qRed(c2));
+
+  d = std::max(d, std::abs(qGreen(c1) - qGreen(c2)));
+  d = std::max(d, std::abs(qBlue (c1) - qBlue (c2)));
+  d = std::max(d, std::abs(qAlpha(c1) - qAlpha(c2)));
+
+  return d;
+}
+
+int maxDiff(const CQColorsPalette &palette) {
+  std::vector<double> x;
+
+  testValues(x);
+
+  std::vector<QRgb> rgb(x.size());
+
+  palette.getColors(x.data(), int(x.size()), rgb.data());
+
+  int d = 0;
+
+  for (size_t i = 0; i < x.size(); ++i)
+    d = std::max(d, rgbDiff(palette.getColor(x[i]).rgba(), rgb[i]));
+
+  return d;
+}
+
+// max diff of SIMD level batch colors from scalar (-1 if level not supported)
+int simdDiff(const CQColorsPalette &palette, CQColorsSIMD::Level level) {
+  using Level = CQColorsSIMD::Level;
+
+  std::vector<double> x;
+
+  testValues(x);
+
+  std::vector<QRgb> rgb1(x.size()), rgb2(x.size());
+
+  CQColorsSIMD::setMaxLevel(Level::NONE);
+
+  palette.getColors(x.data(), int(x.size()), rgb1.data());
+
+  CQColorsSIMD::setMaxLevel(level);
+
+  bool supported = (CQColorsSIMD::level() == level);
+
+  palette.getColors(x.data(), int(x.size()), rgb2.data());
+
+  CQColorsSIMD::setMaxLevel(Level::AVX2);
+
+  if (! supported)
+    return -1;
+
+  int d = 0;
+
+  for (size_t i = 0; i < x.size(); ++i)
+    d = std::max(d, rgbDiff(rgb1[i], rgb2[i]));
+
+  return d;
+}
+
+}
+
+int
+main(int, char **)
+{
+  using ColorModel = CQColorsPalette::ColorModel;
+
+  ColorModel models[] = {
+    ColorModel::RGB, ColorModel::HSV, ColorModel::CMY, ColorModel::YIQ, ColorModel::XYZ };
+
+  int nm = CQColorsPalette::numModels();
+
+  int failed = 0;
+
+  auto check = [&](const CQColorsPalette &palette, const std::string &name) {
+    int d = maxDiff(palette);
+
+    if (d != 0) {
+      std::printf("FAIL %s : max diff %d\n", name.c_str(), d);
+      ++failed;
+    }
+  };
+
+  for (auto model : models) {
+    auto modelName = CQColorsPalette::colorModelToString(model).toStdString();
+
+    for (int gray = 0; gray < 2; ++gray) {
+      for (int negate = 0; negate < 2; ++negate) {
+        for (int r = 0; r < nm; ++r) {
+          CQColorsPalette palette;
+
+          palette.setColorModel(model);
+          palette.setGray(gray);
+          palette.setRgbModel(r, (r + 5) % nm, (r + 11) % nm);
+          palette.setRedNegative(negate);
+
+          check(palette, modelName + " gray " + std::to_string(gray) +
+                         " negate " + std::to_string(negate) + " model " + std::to_string(r));
+        }
+      }
+    }
+  }
+
+  for (int negate = 0; negate < 2; ++negate) {
+    CQColorsPalette palette;
+
+    palette.setCubeHelix(0.5, 1.5, 0.8);
+    palette.setCubeNegative(negate);
+
+    check(palette, "cubehelix negate " + std::to_string(negate));
+  }
+
+  // defined colors with stop count for linear (<= 32) and binary search kernel paths
+  using Level = CQColorsSIMD::Level;
+
+  for (auto model : { ColorModel::RGB, ColorModel::HSV }) {
+    auto modelName = CQColorsPalette::colorModelToString(model).toStdString();
+
+    for (int numStops : { 5, 32, 33, 100 }) {
+      CQColorsPalette palette;
+
+      palette.setColorModel(model);
+
+      CQColorsPalette::DefinedColors colors;
+
+      for (int i = 0; i < numStops; ++i) {
+        double v = (i + 0.1*(i % 3))/(numStops - 1);
+
+        colors.push_back(CQColorsPalette::DefinedColor(v,
+          QColor((i*53) % 256, (i*101 + 40) % 256, (i*197 + 90) % 256)));
+      }
+
+      palette.setDefinedColors(colors);
+
+      for (auto level : { Level::SSE4, Level::AVX2 }) {
+        int d = simdDiff(palette, level);
+
+        // float kernels may round differently from scalar (double) interpolation
+        if (d > 1) {
+          std::printf("FAIL defined %s stops %d level %d : max diff %d\n", modelName.c_str(),
+                      numStops, int(level), d);
+          ++failed;
+        }
+      }
+    }
+  }
+
+  if (failed)
+    return 1;
+
+  std::printf("OK\n");
+
+  return 0;
+}
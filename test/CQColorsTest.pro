@@ -0,0 +1,36 @@
+TEMPLATE = app
+
+TARGET = CQColorsBatchTest
+
+QT += widgets svg
+
+DEPENDPATH += .
+
+QMAKE_CXXFLAGS += \
+-std=c++17 \
+
+CONFIG += c++17
+CONFIG += console
+
+MOC_DIR = .moc
+
+SOURCES += \
+CQColorsBatchTest.cpp \
+
+DESTDIR     = ../bin
+OBJECTS_DIR = ../obj
+
+INCLUDEPATH += \
+. \
+../include \
+../../CQUtil/include \
+../../CUtil/include \
+../../CMath/include \
+../../COS/include \
+/usr/include/tcl \
+
+unix:LIBS += \
+-L../lib \
+-L../../CQUtil/lib \
+-lCQColors -lCQUtil \
+-ltcl \